@@ -0,0 +1,74 @@
+#pragma once
+
+#include "rosban_fa/function_approximator.h"
+
+#include "rosban_utils/serializable.h"
+
+#include <Eigen/Core>
+
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace regression_experiments
+{
+
+/// Parameters of the adaptive refinement of a prediction grid
+class RefinementConfig : public rosban_utils::Serializable
+{
+public:
+  RefinementConfig();
+
+  /// Number of points by dimension of the initial grid (at least 2)
+  std::vector<int> initial_points_by_dim;
+  /// Maximal number of times a cell of the initial grid can be split
+  int max_depth;
+  /// A cell is split if the difference between the extreme values of its
+  /// vertices exceeds the tolerance, negative tolerances are ignored
+  double mean_tolerance;
+  double var_tolerance;
+  /// Tolerance on the norm of the difference between gradients of the vertices
+  double gradient_tolerance;
+  /// Maximal number of points predicted, including the initial grid. When the
+  /// budget does not allow to split all the cells of a depth, cells with the
+  /// largest variation relative to the tolerances are split first
+  long max_points;
+  /// Number of points predicted at once
+  int batch_size;
+  /// Number of threads used for predictions
+  int nb_threads;
+
+  virtual std::string class_name() const override;
+  virtual void to_xml(std::ostream &out) const override;
+  virtual void from_xml(TiXmlNode *node) override;
+};
+
+/// Sparse set of predicted points
+struct AdaptivePrediction
+{
+  /// One point per column
+  Eigen::MatrixXd points;
+  Eigen::VectorXd means;
+  Eigen::VectorXd vars;
+  /// One gradient per column
+  Eigen::MatrixXd gradients;
+  /// Number of points of a dense grid with the same resolution
+  double dense_grid_size;
+};
+
+/// Predict the values of 'fa' on a grid which is refined where the
+/// approximation changes: starting from a regular grid, cells whose vertices
+/// differ by more than a tolerance are split in 2^d cells, until max_depth is
+/// reached or until splitting would exceed max_points. Vertices shared by
+/// several cells are predicted only once.
+///
+/// Dimensions found in 'fixed_values' are not discretized, the provided value
+/// is used instead (see PredictionExporter::exportGrid). Since a cell has 2^d
+/// vertices, refinement is intended for a small number of free dimensions.
+AdaptivePrediction buildAdaptivePrediction(std::shared_ptr<const rosban_fa::FunctionApproximator> fa,
+                                           const Eigen::MatrixXd & limits,
+                                           const RefinementConfig & config,
+                                           const std::map<int, double> & fixed_values
+                                           = std::map<int, double>());
+
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "regression_experiments/benchmark_function.h"
+
+#include "rosban_fa/function_approximator.h"
+
+#include <memory>
+#include <vector>
+
+namespace regression_experiments
+{
+
+/// Quality of the maximum found once a budget has been reached
+struct AnytimePoint
+{
+  /// 'evaluations', 'time' or 'native' (FunctionApproximator::getMaximum)
+  std::string budget_type;
+  /// Budget reached: number of evaluations or time [s] (0 for native)
+  double budget;
+  /// Number of predictions of the approximator used
+  int nb_evaluations;
+  /// Time spent in the search [s]
+  double elapsed_time;
+  /// Value predicted by the approximator at the candidate
+  double expected_max;
+  /// Difference between the true maximum and the value at the candidate, -1 if
+  /// the maximum of the function is unknown
+  double arg_max_loss;
+};
+
+/// Search the maximum of 'fa' inside the limits of 'function' using random
+/// search with candidates drawn from 'stream' by batches of 'batch_size'.
+///
+/// Each time one of the evaluation budgets or one of the time budgets [s] is
+/// reached, the best candidate found so far is recorded. Once the search is
+/// finished, all recorded candidates are evaluated at once with a noise-free
+/// BenchmarkFunction::sampleBatch and compared to BenchmarkFunction::getMax().
+/// The result of fa->getMaximum is added as a reference with budget_type 'native'.
+///
+/// The search stops when all the budgets have been reached
+std::vector<AnytimePoint> runAnytimeProfile(std::shared_ptr<const BenchmarkFunction> function,
+                                            std::shared_ptr<const rosban_fa::FunctionApproximator> fa,
+                                            std::vector<int> evaluation_budgets,
+                                            std::vector<double> time_budgets,
+                                            const RandomStream & stream,
+                                            int batch_size = 64);
+
+}
@@ -1,5 +1,8 @@
 #pragma once
 
+#include "regression_experiments/counter_rng.h"
+#include "regression_experiments/sampling_design.h"
+
 #include "rosban_utils/serializable.h"
 
 #include <Eigen/Core>
@@ -21,9 +24,16 @@ public:
   /// Return the value at given input without any noise observation
   virtual double sample(const Eigen::VectorXd & input) const = 0;
 
+  /// Return the values at the given inputs (one per column) without any noise observation
+  /// Default implementation calls sample on nb_threads threads
+  virtual Eigen::VectorXd sampleBatch(const Eigen::MatrixXd & inputs, int nb_threads) const;
+
   /// Return the maximal value of the function, throw a runtime_error if it is not overriden
   virtual double getMax() const;
 
+  /// Standard deviation of the noise applied to the observations
+  double getObservationNoise() const;
+
   /// Create samples and place them in the provided arguments
   /// Use engine if provided, otherwise, it creates its own engine
   void getUniformSamples(int nb_samples,
@@ -32,6 +42,37 @@ public:
                          std::default_random_engine * engine = NULL,
                          bool apply_noise = true) const;
 
+  /// Create samples and place them in the provided arguments
+  /// Inputs are drawn from substream 0 of 'stream' and noise from substream 1,
+  /// results do not depend on the number of threads used
+  void getUniformSamples(int nb_samples,
+                         Eigen::MatrixXd & samples,
+                         Eigen::VectorXd & observations,
+                         const RandomStream & stream,
+                         bool apply_noise = true,
+                         int nb_threads = 1) const;
+
+  /// Same samples as getUniformSamples with a stream, rounded to single
+  /// precision. Samples are generated by chunks of chunk_size, therefore the
+  /// double precision data never exceeds a chunk
+  void getUniformSamples(int nb_samples,
+                         Eigen::MatrixXf & samples,
+                         Eigen::VectorXf & observations,
+                         const RandomStream & stream,
+                         bool apply_noise = true,
+                         int nb_threads = 1,
+                         int chunk_size = 4096) const;
+
+  /// Create samples with the inputs chosen by 'design' and place them in the
+  /// provided arguments. Inputs use substream 0 of 'stream' and noise substream 1
+  void getSamples(int nb_samples,
+                  Eigen::MatrixXd & samples,
+                  Eigen::VectorXd & observations,
+                  const SamplingDesign & design,
+                  const RandomStream & stream,
+                  bool apply_noise = true,
+                  int nb_threads = 1) const;
+
   virtual void to_xml(std::ostream &out) const override;
   virtual void from_xml(TiXmlNode *node) override;
 
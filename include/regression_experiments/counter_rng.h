@@ -0,0 +1,97 @@
+#pragma once
+
+#include <Eigen/Core>
+
+#include <array>
+#include <cstdint>
+
+namespace regression_experiments
+{
+
+/// Counter-based random generator Philox4x32-10 (Salmon et al., 2011)
+/// A block of 4 random words is a pure function of a counter and a key: there
+/// is no internal state, so any block can be computed independently.
+class Philox4x32
+{
+public:
+  typedef std::array<uint32_t, 4> Counter;
+  typedef std::array<uint32_t, 2> Key;
+
+  /// Return the block associated to the given counter and key
+  static Counter generate(const Counter & counter, const Key & key);
+};
+
+/// Independent random streams used by the benchmarks, each purpose has its own
+/// key, so that adding draws for one purpose never shifts the others
+enum RandomPurpose : uint32_t
+{
+  TrainingSamples = 0,
+  TestSamples = 1,
+  MaxSearch = 2,
+  SequentialDesign = 3,
+  Tuning = 4,
+  FunctionGeneration = 5
+};
+
+/// A stream of random numbers addressed by (seed, cell, trial, purpose, substream)
+///
+/// Element i of a stream depends only on the address of the stream and on i:
+/// generation can be split in any way between threads and streams can be
+/// jumped ahead for free, results are bit-reproducible regardless of the
+/// number of threads used.
+///
+/// Each block of the underlying generator provides 4 words, 2 uniform or 2
+/// gaussian values, a stream contains up to 2^33 values.
+/// Uniform and gaussian sequences of a same stream are built from the same
+/// blocks, use different substreams to get independent values.
+class RandomStream
+{
+public:
+  RandomStream(uint32_t seed = 0, uint32_t cell = 0, uint32_t trial = 0,
+               uint32_t purpose = 0, uint32_t substream = 0);
+
+  /// Return the same stream with a different purpose
+  RandomStream withPurpose(uint32_t purpose) const;
+  /// Return the same stream with a different substream
+  RandomStream withSubstream(uint32_t substream) const;
+
+  /// Fill dst with the words [offset, offset + n[ of the stream
+  void bits(uint64_t offset, size_t n, uint32_t * dst) const;
+  /// Fill dst with the elements [offset, offset + n[ of the uniform sequence
+  /// values are in ]0,1]
+  void uniform(uint64_t offset, size_t n, double * dst) const;
+  /// Fill dst with the elements [offset, offset + n[ of the standard normal sequence
+  void gaussian(uint64_t offset, size_t n, double * dst) const;
+
+  /// Return the first n elements of the uniform sequence
+  Eigen::VectorXd uniform(int n, int nb_threads = 1) const;
+  /// Return the first n elements of the standard normal sequence
+  Eigen::VectorXd gaussian(int n, int nb_threads = 1) const;
+
+  /// Return a matrix with nb_samples columns uniformly drawn inside limits
+  /// Value at (dim, sample) is element (sample * dims + dim) of the uniform sequence
+  Eigen::MatrixXd uniformSamples(const Eigen::MatrixXd & limits, int nb_samples,
+                                 int nb_threads = 1) const;
+  /// Return the columns [first_sample, first_sample + nb_samples[ of
+  /// uniformSamples, allowing large sets to be generated by chunks
+  Eigen::MatrixXd uniformSamples(const Eigen::MatrixXd & limits, int first_sample,
+                                 int nb_samples, int nb_threads) const;
+
+  uint32_t getSeed() const;
+  uint32_t getCell() const;
+  uint32_t getTrial() const;
+  uint32_t getPurpose() const;
+  uint32_t getSubstream() const;
+
+private:
+  /// Compute the blocks [first_block, first_block + nb_blocks[ of the stream
+  void generateBlocks(uint64_t first_block, size_t nb_blocks, uint32_t * dst) const;
+
+  uint32_t seed;
+  uint32_t cell;
+  uint32_t trial;
+  uint32_t purpose;
+  uint32_t substream;
+};
+
+}
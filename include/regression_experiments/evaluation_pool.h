@@ -0,0 +1,73 @@
+#pragma once
+
+#include <Eigen/Core>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace regression_experiments
+{
+
+/// A pool of threads evaluating an expensive function asynchronously
+///
+/// Inputs are submitted by batches (one input per column), the workers
+/// process chunks of 'chunk_size' consecutive inputs. Batches submitted by
+/// different threads are processed in submission order and share the workers,
+/// the pool is therefore safe to use from several benchmark workers.
+class EvaluationPool
+{
+public:
+  typedef std::function<double(const Eigen::VectorXd &)> Evaluator;
+
+  EvaluationPool(Evaluator evaluator, int nb_workers, int chunk_size = 1);
+  ~EvaluationPool();
+
+  /// Start the evaluation of all the columns of inputs, the returned future
+  /// holds the values in the same order, or the first exception thrown
+  std::future<Eigen::VectorXd> submit(const Eigen::MatrixXd & inputs);
+
+  /// Evaluate all the columns of inputs and wait for the results. If
+  /// batch_time is not null, it receives the sum of the durations of the
+  /// evaluations of this batch [s]
+  Eigen::VectorXd evaluate(const Eigen::MatrixXd & inputs, double * batch_time = nullptr);
+
+  int getNbWorkers() const;
+
+  /// Number of evaluations performed since the creation of the pool
+  long getNbEvaluations() const;
+
+  /// Sum of the durations of all the evaluations [s]
+  double getEvaluationTime() const;
+
+private:
+  struct Batch;
+
+  /// Queue a batch, its future is already retrieved
+  std::shared_ptr<Batch> enqueue(const Eigen::MatrixXd & inputs);
+
+  /// Main loop of the workers
+  void work();
+
+  Evaluator evaluator;
+  int chunk_size;
+
+  std::mutex mutex;
+  std::condition_variable condition;
+  /// Batches with inputs not yet assigned to a worker
+  std::deque<std::shared_ptr<Batch>> queue;
+  bool stopping;
+  std::vector<std::thread> workers;
+
+  std::atomic<long> nb_evaluations;
+  /// Evaluation time in nanoseconds
+  std::atomic<long long> evaluation_time;
+};
+
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "regression_experiments/benchmark_function.h"
+#include "regression_experiments/evaluation_pool.h"
+
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace regression_experiments
+{
+
+/// Wrap a benchmark function to emulate an expensive black-box simulator
+///
+/// Each evaluation costs at least 'cost' seconds, either sleeping ('sleep',
+/// like an external simulator) or busy waiting ('busy', like a cpu bound
+/// simulator). If 'command' is not empty, each evaluation runs
+/// 'command x_1 ... x_d' in a shell and uses the first value written on its
+/// standard output instead of the wrapped function. The wrapped function
+/// always provides the limits and the maximum.
+///
+/// Batches are evaluated by a pool of nb_evaluators threads shared by all the
+/// users of the function, the noise of the wrapped function is not used.
+class ExpensiveFunction : public BenchmarkFunction
+{
+public:
+  ExpensiveFunction();
+
+  virtual Eigen::MatrixXd getLimits() const override;
+  virtual double sample(const Eigen::VectorXd & input) const override;
+  /// nb_threads is ignored, evaluations are run by the pool
+  virtual Eigen::VectorXd sampleBatch(const Eigen::MatrixXd & inputs,
+                                      int nb_threads) const override;
+  virtual double getMax() const override;
+
+  /// Number of evaluations and total evaluation time of the pool
+  long getNbEvaluations() const;
+  double getEvaluationTime() const;
+
+  /// Evaluation time of the batches submitted by the calling thread [s], this
+  /// isolates the evaluations of a benchmark worker from the other workers
+  /// sharing the pool
+  double getThreadEvaluationTime() const;
+
+  virtual std::string class_name() const override;
+  virtual void to_xml(std::ostream &out) const override;
+  virtual void from_xml(TiXmlNode *node) override;
+
+private:
+  /// Run the command for the given input and parse its output
+  double runCommand(const Eigen::VectorXd & input) const;
+
+  /// Wait until 'cost' seconds have elapsed since start
+  void payCost(std::chrono::steady_clock::time_point start) const;
+
+  /// The function emulated
+  std::shared_ptr<const BenchmarkFunction> function;
+  /// Minimal duration of an evaluation [s]
+  double cost;
+  /// 'sleep' or 'busy'
+  std::string cost_mode;
+  /// If not empty, the external process used for evaluations
+  std::string command;
+  /// Number of evaluations run simultaneously
+  int nb_evaluators;
+  /// Number of consecutive inputs of a batch handled at once by an evaluator
+  int chunk_size;
+
+  std::unique_ptr<EvaluationPool> pool;
+
+  /// Evaluation time of the batches submitted by each thread [s]
+  mutable std::map<std::thread::id, double> thread_evaluation_times;
+  mutable std::mutex thread_mutex;
+};
+
+}
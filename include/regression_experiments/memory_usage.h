@@ -0,0 +1,10 @@
+#pragma once
+
+namespace regression_experiments
+{
+
+/// Peak and current resident set size of the process [kB], -1 if unavailable
+long getPeakRSS();
+long getCurrentRSS();
+
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <functional>
+
+namespace regression_experiments
+{
+
+/// Split [0, nb_items) in at most nb_threads contiguous ranges and run
+/// task(start, end) on each of them in a separate thread, the calling thread
+/// handles the first range. If a task throws, the first exception caught is
+/// rethrown once all threads have been joined.
+void runParallel(int nb_items, int nb_threads,
+                 const std::function<void(int start, int end)> & task);
+
+}
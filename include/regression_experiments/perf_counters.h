@@ -0,0 +1,62 @@
+#pragma once
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace regression_experiments
+{
+
+/// Values read from the hardware counters, -1 when a counter is unavailable
+struct PerfValues
+{
+  PerfValues();
+
+  long cycles;
+  long instructions;
+  long l1d_misses;
+  long llc_misses;
+  long branch_misses;
+  long context_switches;
+
+  /// Names of the columns, each one prefixed by 'prefix'
+  static std::string csvHeader(const std::string & prefix);
+  /// Write the values separated by ','
+  void writeCsv(std::ostream & out) const;
+};
+
+/// Hardware performance counters of the calling thread obtained with Linux
+/// perf_event_open. Threads created by the calling thread while the counters
+/// exist are included in the measure (e.g. threads spawned by a trainer).
+///
+/// Values are therefore per calling thread, not per thread: each benchmark
+/// worker opens its own counters, but the counts of the threads it spawns are
+/// merged into its values when they exit and cannot be told apart. Threads
+/// still running at stop() are not counted.
+///
+/// Counters which cannot be opened (not linux, perf_event_paranoid,
+/// virtualized hosts, ...) are reported as -1, the measure never fails.
+/// If the kernel multiplexes the counters, values are scaled accordingly.
+class PerfCounters
+{
+public:
+  PerfCounters();
+  ~PerfCounters();
+
+  PerfCounters(const PerfCounters & other) = delete;
+  PerfCounters & operator=(const PerfCounters & other) = delete;
+
+  /// Return true if at least one of the counters is available
+  bool isAvailable() const;
+
+  /// Reset and enable all counters
+  void start();
+  /// Disable the counters and return their values since the last start
+  PerfValues stop();
+
+private:
+  /// File descriptors of the counters (-1 if unavailable), same order as PerfValues
+  std::vector<int> fds;
+};
+
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace regression_experiments
+{
+
+/// Cpus of the machine grouped by NUMA node
+class CpuTopology
+{
+public:
+  /// Read the topology from /sys/devices/system/node, if it is not available,
+  /// all the cpus are considered to be on a single node of unknown id.
+  /// Memory-only nodes are skipped, therefore indices of the nodes may
+  /// differ from their kernel ids
+  static CpuTopology detect();
+
+  int getNbNodes() const;
+  int getNbCpus() const;
+  /// 'node' is an index in [0, getNbNodes()[
+  const std::vector<int> & getNodeCpus(int node) const;
+  /// Kernel id of the node at the given index, -1 if unknown
+  int getNodeId(int node) const;
+
+  /// Human readable description: 'node0:0-7;node1:8-15'
+  std::string toString() const;
+
+private:
+  /// node index -> cpus
+  std::vector<std::vector<int>> nodes;
+  /// node index -> kernel id
+  std::vector<int> node_ids;
+};
+
+/// How workers are placed on the cpus
+/// - None: no pinning, the OS schedules the threads
+/// - Compact: workers use consecutive cpus, a node is filled before the next one
+/// - Spread: workers are distributed round-robin over the nodes
+/// - NumaNode: one worker per node, using all the cpus of its node
+enum class PlacementPolicy
+{
+  None,
+  Compact,
+  Spread,
+  NumaNode
+};
+
+/// Names are 'none', 'compact', 'spread' and 'numa_node'
+PlacementPolicy parsePlacementPolicy(const std::string & name);
+std::string toString(PlacementPolicy policy);
+
+/// The cpus on which a worker and all its threads run
+struct WorkerPlacement
+{
+  /// Kernel id of the node, -1 if the worker is not bound to a node
+  int numa_node;
+  /// Empty if the worker is not pinned
+  std::vector<int> cpus;
+};
+
+/// Assign cpus to each worker, each worker uses 'threads_per_worker' cpus
+/// (except for NumaNode). If there are not enough cpus, some are shared.
+std::vector<WorkerPlacement> computePlacement(const CpuTopology & topology,
+                                              PlacementPolicy policy,
+                                              int nb_workers,
+                                              int threads_per_worker);
+
+/// Pin the calling thread on the cpus of 'placement' and make it allocate
+/// memory on its node preferably. Threads created afterwards by the calling
+/// thread inherit both settings, hence data first-touched by the worker and
+/// by the trainer threads stays on the node. Return false if either the cpu
+/// affinity or the memory policy could not be applied.
+bool applyPlacement(const WorkerPlacement & placement);
+
+/// Format a list of cpus as '0-3,8'
+std::string cpusToString(const std::vector<int> & cpus);
+
+}
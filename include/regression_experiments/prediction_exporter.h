@@ -0,0 +1,74 @@
+#pragma once
+
+#include "rosban_fa/function_approximator.h"
+
+#include <Eigen/Core>
+
+#include <fstream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <vector>
+
+namespace regression_experiments
+{
+
+/// Write observations and predictions of a function approximator to a csv file
+/// Format: type,input_0,...,input_n,mean,min,max,gradient_0,...,gradient_n
+/// - All input dimensions and the full gradient are written
+/// - Lines are buffered and written by chunks of 'chunk_size' lines
+/// - Grids are never stored: points are generated, predicted and written chunk by chunk
+class PredictionExporter
+{
+public:
+  /// Open the file at 'path' and write the header for the given input dimension
+  PredictionExporter(const std::string & path, int input_dim, int chunk_size = 4096);
+  /// Flush the remaining lines and close the file
+  ~PredictionExporter();
+
+  /// Write the samples used to train the approximator
+  /// (min, max and gradient carry no meaning and are set to 0)
+  void writeObservations(const Eigen::MatrixXd & inputs,
+                         const Eigen::VectorXd & outputs);
+
+  /// Write predictions which have already been computed
+  void writePredictions(const Eigen::MatrixXd & points,
+                        const Eigen::VectorXd & means,
+                        const Eigen::VectorXd & vars,
+                        const Eigen::MatrixXd & gradients);
+
+  /// Predict and write the values of 'fa' on a grid of the given space
+  /// Dimensions found in 'fixed_values' are not discretized, the provided value
+  /// is used instead, this allows to export axis-aligned slices of high
+  /// dimensional models without predicting over the full grid (nothing is
+  /// marginalized over the fixed dimensions).
+  /// Other dimensions use points_by_dim (same behavior as discretizeSpace)
+  /// Return the number of points predicted
+  long exportGrid(std::shared_ptr<const rosban_fa::FunctionApproximator> fa,
+                  const Eigen::MatrixXd & limits,
+                  const std::vector<int> & points_by_dim,
+                  const std::map<int, double> & fixed_values = std::map<int, double>());
+
+  /// Write the buffered lines to the file
+  void flush();
+
+private:
+  /// Append a line to the buffer and flush it if the chunk is full
+  void writeLine(const std::string & type,
+                 const Eigen::VectorXd & input,
+                 double mean, double min, double max,
+                 const Eigen::VectorXd & gradient);
+
+  /// The output stream
+  std::ofstream out;
+  /// Lines waiting to be written
+  std::ostringstream buffer;
+  /// Number of lines currently in the buffer
+  int buffered_lines;
+  /// Number of lines written at once
+  int chunk_size;
+  /// Number of dimensions of the input space
+  int input_dim;
+};
+
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace regression_experiments
+{
+
+/// Progress of a campaign made of independent cells run by several workers
+///
+/// Workers notify the start and the end of each cell, which costs a single
+/// lock. A background thread periodically rewrites a JSON status file and,
+/// if a socket path is provided, answers connections on a Unix socket with
+/// the same JSON document (e.g. 'nc -U path' or
+/// 'curl --unix-socket path http://localhost/').
+///
+/// Cells belong to groups (e.g. methods) and have a size (e.g. number of
+/// samples). The duration of a cell is modeled per group as c * size^a,
+/// fitted on the cells completed, which provides the ETA.
+class ProgressMonitor
+{
+public:
+  ProgressMonitor(int nb_workers);
+  ~ProgressMonitor();
+
+  ProgressMonitor(const ProgressMonitor & other) = delete;
+  ProgressMonitor & operator=(const ProgressMonitor & other) = delete;
+
+  /// Declare nb_cells cells which will be run
+  void plan(const std::string & group, double size, int nb_cells);
+  /// Remove nb_cells planned cells which will not be run
+  void cancel(const std::string & group, double size, int nb_cells);
+
+  /// Worker 'worker_id' starts a planned cell, description is displayed as is
+  void startCell(int worker_id, const std::string & group, double size,
+                 const std::string & description);
+  /// Worker 'worker_id' has completed its current cell
+  void endCell(int worker_id);
+
+  /// Start the background thread, status_path and socket_path are ignored if empty
+  void start(const std::string & status_path, const std::string & socket_path,
+             double period);
+  /// Write a last status and stop the background thread
+  void stop();
+
+  /// JSON document describing the current state
+  std::string getStatus() const;
+
+private:
+  typedef std::chrono::steady_clock Clock;
+
+  struct WorkerStatus
+  {
+    WorkerStatus();
+
+    bool busy;
+    std::string group;
+    double size;
+    std::string description;
+    Clock::time_point cell_start;
+    int nb_completed;
+  };
+
+  /// Durations of the completed cells of a group: (size, duration [s])
+  typedef std::vector<std::pair<double, double>> Durations;
+
+  /// Body of the background thread
+  void run();
+  /// Write the status to a temporary file and rename it, readers never see a
+  /// partially written file
+  void writeStatus() const;
+  /// Answer a pending connection on the socket
+  void answerConnection() const;
+
+  /// Protects all the members describing the progress
+  mutable std::mutex mutex;
+  Clock::time_point creation;
+  std::vector<WorkerStatus> workers;
+  /// group -> size -> number of cells not started yet
+  std::map<std::string, std::map<double, int>> pending;
+  std::map<std::string, Durations> durations;
+  int nb_completed;
+  bool finished;
+
+  std::string status_path;
+  std::string socket_path;
+  /// Time between two writes of the status file [s]
+  double period;
+  int socket_fd;
+  std::atomic<bool> stop_requested;
+  std::thread thread;
+};
+
+}
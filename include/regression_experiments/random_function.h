@@ -0,0 +1,96 @@
+#pragma once
+
+#include "regression_experiments/benchmark_function.h"
+
+#include <map>
+#include <memory>
+
+namespace regression_experiments
+{
+
+/// A family of random functions on [0,1]^d identified by a seed
+///
+/// Dimensions are shuffled and split in groups of group_size, the function is
+/// the sum of one independent component per group. Each component is:
+/// - A draw of a gaussian process with a squared exponential kernel of the
+///   given length_scale, approximated with nb_features random Fourier features
+/// - nb_discontinuities steps h * [x_i > t] with h ~ N(0, discontinuity_amplitude)
+///   and t uniform in [0.1, 0.9]
+/// The smooth part has a variance close to 1 whatever the number of groups.
+///
+/// Since components do not share dimensions, the maximum is the sum of their
+/// maxima. Each one is searched on a grid containing the thresholds of the
+/// steps and refined by compass search, this is done once at construction.
+class RandomFunction : public BenchmarkFunction
+{
+public:
+  RandomFunction(int nb_dimensions = 1, uint32_t seed = 0);
+
+  /// Draw a new function with the same properties
+  void setSeed(uint32_t seed);
+
+  virtual Eigen::MatrixXd getLimits() const override;
+  virtual double sample(const Eigen::VectorXd & input) const override;
+  /// Inputs are evaluated by chunks of columns, each chunk uses matrix products
+  virtual Eigen::VectorXd sampleBatch(const Eigen::MatrixXd & inputs,
+                                      int nb_threads) const override;
+  virtual double getMax() const override;
+
+  virtual std::string class_name() const override;
+  virtual void to_xml(std::ostream &out) const override;
+  virtual void from_xml(TiXmlNode *node) override;
+
+private:
+  /// Component of the function, defined on a group of dimensions
+  struct Component
+  {
+    /// Dimensions of the input used
+    std::vector<int> dims;
+    /// One row per feature, one column per dimension of the group
+    Eigen::MatrixXd frequencies;
+    Eigen::VectorXd phases;
+    Eigen::VectorXd weights;
+    /// Index in the group of the dimension of each step
+    std::vector<int> step_dims;
+    std::vector<double> thresholds;
+    std::vector<double> heights;
+    /// Maximal value of the component
+    double max;
+  };
+
+  /// Draw the components and compute their maxima
+  void generate();
+
+  /// Values of the component for group inputs (one column per input)
+  Eigen::VectorXd evaluate(const Component & component,
+                           const Eigen::MatrixXd & group_inputs) const;
+
+  /// Values of the function for inputs (one column per input)
+  Eigen::VectorXd evaluate(const Eigen::MatrixXd & inputs) const;
+
+  /// Maximal value of the component over [0,1]^dims
+  double computeMax(const Component & component) const;
+
+  int nb_dimensions;
+  uint32_t seed;
+  /// Number of dimensions of each component
+  int group_size;
+  /// Number of random Fourier features of each component
+  int nb_features;
+  /// Length scale of the kernel, lower values give less smooth functions
+  double length_scale;
+  /// Number of steps of each component
+  int nb_discontinuities;
+  /// Standard deviation of the height of the steps
+  double discontinuity_amplitude;
+
+  std::vector<Component> components;
+  double max_value;
+};
+
+/// nb_functions copies of the prototype using seeds first_seed, first_seed + 1, ...
+/// Functions are named 'random_<seed>'
+std::map<std::string, std::shared_ptr<const BenchmarkFunction>>
+buildRandomSuite(const RandomFunction & prototype, int nb_functions, uint32_t first_seed);
+
+}
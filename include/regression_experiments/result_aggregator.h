@@ -0,0 +1,122 @@
+#pragma once
+
+#include <istream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace regression_experiments
+{
+
+/// Streaming estimation of a quantile with constant memory: P² algorithm
+/// (Jain & Chlamtac, 1985). Exact for the first 5 values.
+class P2Quantile
+{
+public:
+  P2Quantile(double p = 0.5);
+
+  void add(double value);
+  double get() const;
+
+private:
+  double p;
+  int count;
+  /// Height of the markers
+  double heights[5];
+  /// Actual positions of the markers
+  double positions[5];
+  /// Desired positions of the markers and their increments
+  double desired[5];
+  double increments[5];
+};
+
+/// Streaming statistics of a metric: mean, variance, extrema and quantiles
+class MetricStats
+{
+public:
+  MetricStats();
+
+  void add(double value);
+
+  int getCount() const;
+  double getMean() const;
+  double getStdDev() const;
+  /// Half-width of the 95% confidence interval of the mean (Student)
+  double getCI() const;
+  double getMin() const;
+  double getMax() const;
+  /// Quantiles estimated: see getQuantileProbabilities
+  std::vector<double> getQuantiles() const;
+
+  static const std::vector<double> & getQuantileProbabilities();
+
+private:
+  int count;
+  double mean;
+  /// Sum of squared differences to the mean (Welford)
+  double m2;
+  double min;
+  double max;
+  std::vector<P2Quantile> quantiles;
+};
+
+/// Aggregate csv result files in a single pass over their lines
+///
+/// Lines are grouped by the values of the key columns (by default:
+/// function_name, method, nb_samples), all other columns which contain
+/// numbers are considered as metrics. Optional key columns (by default: design
+/// and precision) are keys of the files which contain them, they are written
+/// if at least one file contains them and are empty for the lines of the other
+/// files. Ignored columns (by default: the placement ids worker and numa_node)
+/// are neither keys nor metrics. Memory usage depends only on the number of
+/// groups and metrics, not on the number of lines.
+class ResultAggregator
+{
+public:
+  ResultAggregator(const std::vector<std::string> & key_columns =
+                   {"function_name", "method", "nb_samples"},
+                   const std::vector<std::string> & optional_key_columns =
+                   {"design", "precision"},
+                   const std::vector<std::string> & ignored_columns =
+                   {"worker", "numa_node"});
+
+  /// Read all the lines of a csv file with a header
+  void addFile(const std::string & path);
+  void addStream(std::istream & in);
+
+  /// Write a line per (group, metric) with count, mean, ci and quantiles
+  void writeSummary(const std::string & path) const;
+
+  /// Write the groups which are not dominated regarding (accuracy, cost), both
+  /// minimized, using the mean of each metric. The frontier is computed
+  /// separately for each value of the first key column (e.g. each function).
+  /// Each entry of 'objectives' is a pair (accuracy_metric, cost_metric).
+  void writeParetoFront(const std::string & path,
+                        const std::vector<std::pair<std::string, std::string>> & objectives) const;
+
+  /// Number of lines read
+  long getNbLines() const;
+
+private:
+  /// Return the index of the metric, creating it if necessary
+  int getMetricIndex(const std::string & name);
+
+  /// Header of the key columns used, followed by ','
+  std::string keysHeader() const;
+  /// Values of the key columns used, joined with ','
+  std::string joinKey(const std::vector<std::string> & key) const;
+
+  /// Mandatory key columns followed by the optional ones
+  std::vector<std::string> key_columns;
+  size_t nb_mandatory_keys;
+  /// Has the key column been found in at least one file?
+  std::vector<bool> used_keys;
+  std::vector<std::string> ignored_columns;
+  std::vector<std::string> metric_names;
+  std::map<std::string, int> metric_indices;
+  /// Key values (same order as key_columns) -> stats for each metric
+  std::map<std::vector<std::string>, std::vector<MetricStats>> groups;
+  long nb_lines;
+};
+
+}
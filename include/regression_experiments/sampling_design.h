@@ -0,0 +1,48 @@
+#pragma once
+
+#include "regression_experiments/counter_rng.h"
+
+#include "rosban_utils/serializable.h"
+
+#include <Eigen/Core>
+
+namespace regression_experiments
+{
+
+/// A method to choose the inputs of the training samples
+///
+/// Designs draw their random numbers from the provided stream only, different
+/// parts of the designs use different offsets of the stream. Therefore,
+/// results do not depend on the number of threads used.
+class SamplingDesign : public rosban_utils::Serializable
+{
+public:
+  virtual ~SamplingDesign() {}
+
+  /// Return a matrix with nb_samples columns inside limits
+  virtual Eigen::MatrixXd getSamples(const Eigen::MatrixXd & limits,
+                                     int nb_samples,
+                                     const RandomStream & stream,
+                                     int nb_threads) const = 0;
+
+  virtual void to_xml(std::ostream &out) const override;
+  virtual void from_xml(TiXmlNode *node) override;
+
+protected:
+  /// Map points from the unit hypercube to the given limits
+  static void scaleToLimits(const Eigen::MatrixXd & limits, Eigen::MatrixXd & points);
+};
+
+/// i.i.d. uniform samples
+class UniformDesign : public SamplingDesign
+{
+public:
+  virtual Eigen::MatrixXd getSamples(const Eigen::MatrixXd & limits,
+                                     int nb_samples,
+                                     const RandomStream & stream,
+                                     int nb_threads) const override;
+
+  virtual std::string class_name() const override;
+};
+
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "regression_experiments/sampling_design.h"
+
+#include "rosban_utils/factory.h"
+
+namespace regression_experiments
+{
+
+class SamplingDesignFactory : public rosban_utils::Factory<SamplingDesign>
+{
+public:
+  SamplingDesignFactory();
+};
+
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace regression_experiments
+{
+
+/// A value measured for a given number of samples and input dimensions
+struct ScalingObservation
+{
+  double nb_samples;
+  double nb_dimensions;
+  double value;
+};
+
+/// Empirical law: value = coefficient * nb_samples^a * nb_dimensions^b
+///
+/// Exponents are fitted by least squares on the logarithms, bounds are the 95%
+/// confidence interval of each exponent (Student distribution). If all the
+/// observations share the same number of samples (resp. dimensions), the
+/// corresponding exponent is 0 and its bounds are NaN.
+struct ScalingLaw
+{
+  ScalingLaw();
+
+  double coefficient;
+  double samples_exponent;
+  double samples_low;
+  double samples_high;
+  double dimensions_exponent;
+  double dimensions_low;
+  double dimensions_high;
+  /// Coefficient of determination in log space
+  double r2;
+  int nb_observations;
+
+  /// Value predicted by the law
+  double predict(double nb_samples, double nb_dimensions) const;
+
+  /// Largest number of samples for which the predicted value stays below
+  /// 'budget' at the given dimension, infinity if the value does not grow
+  /// with the number of samples
+  double maxSamples(double budget, double nb_dimensions) const;
+
+  /// Names of the columns
+  static std::string csvHeader();
+  /// Write the values separated by ','
+  void writeCsv(std::ostream & out) const;
+};
+
+/// Fit a ScalingLaw on the observations, values are floored at 'min_value' to
+/// allow logarithms (e.g. a null smse). Throw a logic_error if there are no
+/// observations
+ScalingLaw fitScalingLaw(const std::vector<ScalingObservation> & observations,
+                         double min_value = 1e-12);
+
+}
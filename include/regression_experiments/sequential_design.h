@@ -0,0 +1,50 @@
+#pragma once
+
+#include "regression_experiments/benchmark_function.h"
+
+#include "rosban_fa/function_approximator.h"
+#include "rosban_fa/trainer.h"
+
+#include <memory>
+#include <vector>
+
+namespace regression_experiments
+{
+
+/// Measures of one iteration of the fit / getMaximum / sample loop, times in seconds
+struct SequentialIteration
+{
+  /// Starts at 0
+  int iteration;
+  /// Number of samples used for the fit
+  int nb_samples;
+  double fit_time;
+  double max_search_time;
+  /// Time spent evaluating the function at the proposed input
+  double evaluation_time;
+  /// Wall time since the beginning of the loop, initial samples excluded
+  double cumulative_time;
+  /// Value predicted at the proposed input
+  double expected_max;
+  /// getMax() minus the value at the proposed input, -1 if getMax() is unknown
+  double arg_max_loss;
+  /// getMax() minus the best noise-free value among all the samples,
+  /// including the one added at this iteration. -1 if getMax() is unknown
+  double simple_regret;
+};
+
+/// Run a closed loop of nb_iterations: fit the trainer, search the maximum of
+/// the approximator, sample the function there and add it to the samples.
+///
+/// Initial samples are drawn uniformly from 'stream' (purpose TrainingSamples)
+/// and the noise of the new observations uses the purpose SequentialDesign.
+/// The approximator is trained from scratch at each iteration.
+std::vector<SequentialIteration>
+runSequentialDesign(std::shared_ptr<const BenchmarkFunction> function,
+                    std::shared_ptr<const rosban_fa::Trainer> trainer,
+                    int nb_initial_samples,
+                    int nb_iterations,
+                    const RandomStream & stream,
+                    int nb_threads = 1);
+
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "regression_experiments/sampling_design.h"
+
+namespace regression_experiments
+{
+
+/// Sobol sequence (Joe & Kuo direction numbers, up to 21 dimensions) with
+/// random linear matrix scrambling and digital shift (Matousek, 1998)
+/// Points are computed directly from their index: generation is parallel
+class SobolDesign : public SamplingDesign
+{
+public:
+  SobolDesign();
+
+  virtual Eigen::MatrixXd getSamples(const Eigen::MatrixXd & limits,
+                                     int nb_samples,
+                                     const RandomStream & stream,
+                                     int nb_threads) const override;
+
+  virtual std::string class_name() const override;
+  virtual void to_xml(std::ostream &out) const override;
+  virtual void from_xml(TiXmlNode *node) override;
+
+  /// Maximal number of dimensions supported
+  static int getMaxDimensions();
+
+private:
+  /// Should the sequence be scrambled?
+  bool scrambled;
+};
+
+/// Halton sequence with random digit permutations (one permutation per
+/// dimension and per digit), up to 32 dimensions
+class HaltonDesign : public SamplingDesign
+{
+public:
+  HaltonDesign();
+
+  virtual Eigen::MatrixXd getSamples(const Eigen::MatrixXd & limits,
+                                     int nb_samples,
+                                     const RandomStream & stream,
+                                     int nb_threads) const override;
+
+  virtual std::string class_name() const override;
+  virtual void to_xml(std::ostream &out) const override;
+  virtual void from_xml(TiXmlNode *node) override;
+
+  /// Maximal number of dimensions supported
+  static int getMaxDimensions();
+
+private:
+  /// Should the sequence be scrambled?
+  bool scrambled;
+};
+
+/// Latin hypercube: each dimension is divided in nb_samples strata containing
+/// exactly one sample, the position inside the strata is uniform
+class LatinHypercubeDesign : public SamplingDesign
+{
+public:
+  virtual Eigen::MatrixXd getSamples(const Eigen::MatrixXd & limits,
+                                     int nb_samples,
+                                     const RandomStream & stream,
+                                     int nb_threads) const override;
+
+  virtual std::string class_name() const override;
+
+  /// Latin hypercube in the unit hypercube using the elements of the stream
+  /// starting at 'offset', uses 2 * nb_samples * dims elements
+  static Eigen::MatrixXd getUnitSamples(int dims, int nb_samples,
+                                        const RandomStream & stream, uint64_t offset,
+                                        int nb_threads);
+};
+
+/// Among nb_candidates latin hypercubes, choose the one with the largest
+/// minimal distance between two samples
+///
+/// Computing the minimal distance visits 3^dims cells per sample, for large
+/// sets in high dimension, nb_candidates should be reduced accordingly
+class MaximinLatinHypercubeDesign : public SamplingDesign
+{
+public:
+  MaximinLatinHypercubeDesign();
+
+  virtual Eigen::MatrixXd getSamples(const Eigen::MatrixXd & limits,
+                                     int nb_samples,
+                                     const RandomStream & stream,
+                                     int nb_threads) const override;
+
+  virtual std::string class_name() const override;
+  virtual void to_xml(std::ostream &out) const override;
+  virtual void from_xml(TiXmlNode *node) override;
+
+  /// Minimal distance between two columns of points.
+  /// For large sets, only pairs in neighbouring cells of a regular grid are
+  /// considered, which is exact as soon as the minimal distance is smaller
+  /// than the size of a cell (always the case in practice for random designs)
+  static double getMinDistance(const Eigen::MatrixXd & points, int nb_threads);
+
+private:
+  /// Number of latin hypercubes generated
+  int nb_candidates;
+};
+
+}
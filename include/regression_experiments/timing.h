@@ -0,0 +1,111 @@
+#pragma once
+
+#include "rosban_utils/serializable.h"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace regression_experiments
+{
+
+/// How a phase is repeated to obtain a reliable duration
+class TimingOptions : public rosban_utils::Serializable
+{
+public:
+  TimingOptions();
+
+  /// Number of runs discarded before the measures (page faults, allocator
+  /// growth, frequency ramp-up, cold caches)
+  int nb_warmup;
+  /// Bounds on the number of measured runs
+  int min_repetitions;
+  int max_repetitions;
+  /// Repetitions stop once the half-width of the confidence interval of the
+  /// median is below this ratio of the median
+  double target_precision;
+  /// Measures further than outlier_threshold scaled MADs from the median are
+  /// discarded
+  double outlier_threshold;
+  /// Repetitions stop once this time has been spent measuring [s]
+  double max_time;
+
+  virtual std::string class_name() const override;
+  virtual void to_xml(std::ostream &out) const override;
+  virtual void from_xml(TiXmlNode *node) override;
+};
+
+/// State of the machine when a measure was taken
+struct MachineState
+{
+  MachineState();
+
+  /// Current frequencies of the cpus allowed for the calling thread [MHz],
+  /// -1 if unavailable
+  double min_frequency;
+  double max_frequency;
+  /// Governor of the cpu running the calling thread, 'unknown' if unavailable
+  std::string governor;
+  /// Load average over the last minute
+  double load_average;
+  /// Cpus allowed for the calling thread (e.g. '0-3,8')
+  std::string allowed_cpus;
+  /// Cpu running the calling thread
+  int current_cpu;
+
+  /// Read the state from /sys, /proc and the scheduler
+  static MachineState capture();
+
+  /// Summary of several states: range of the frequencies, maximal load
+  /// average, governor, allowed cpus and current cpu of the last state or
+  /// 'mixed' (-1 for the cpu) if they differ
+  static MachineState merge(const std::vector<MachineState> & states);
+
+  /// Names of the columns, each one prefixed by 'prefix'
+  static std::string csvHeader(const std::string & prefix);
+  /// Write the values separated by ','
+  void writeCsv(std::ostream & out) const;
+};
+
+/// Summary of the repeated measures of a duration [s]
+struct TimingSummary
+{
+  TimingSummary();
+
+  double median;
+  /// 95% confidence interval of the median
+  double ci_low;
+  double ci_high;
+  /// Number of measures kept and discarded
+  int nb_measures;
+  int nb_outliers;
+  int nb_warmup;
+  /// Was target_precision reached?
+  bool stable;
+  /// All the measured durations (warmup excluded, outliers included) and the
+  /// state captured right after each of them
+  std::vector<double> measures;
+  std::vector<MachineState> machines;
+  /// Merge of the states of all the measures
+  MachineState machine;
+
+  /// Names of the columns, each one prefixed by 'prefix'
+  static std::string csvHeader(const std::string & prefix);
+  /// Write the values separated by ','
+  void writeCsv(std::ostream & out) const;
+};
+
+/// Remove the outliers of 'measures' and compute the median with its
+/// confidence interval from order statistics (no assumption on the
+/// distribution). With few measures, the interval spans all the measures.
+TimingSummary summarizeMeasures(const std::vector<double> & measures,
+                                double outlier_threshold);
+
+/// Call 'measure' nb_warmup times ignoring the result, then until the median
+/// is stable according to 'options'. 'measure' runs the phase once and returns
+/// its duration [s]. The machine state is captured after each measure, out of
+/// the measured durations.
+TimingSummary measureRepeated(const std::function<double()> & measure,
+                              const TimingOptions & options);
+
+}
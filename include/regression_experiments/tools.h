@@ -1,17 +1,96 @@
 #pragma once
 
+#include "regression_experiments/adaptive_grid.h"
 #include "regression_experiments/benchmark_function.h"
+#include "regression_experiments/perf_counters.h"
+#include "regression_experiments/timing.h"
 
 #include "rosban_fa/function_approximator.h"
 #include "rosban_fa/trainer.h"
 
 #include <Eigen/Core>
 
+#include <map>
 #include <memory>
 
 namespace regression_experiments
 {
 
+/// Options of runBenchmark
+struct BenchmarkOptions
+{
+  BenchmarkOptions();
+
+  /// Number of threads used to generate the samples
+  int nb_threads;
+  /// Collect hardware performance counters for each phase, summed over the
+  /// calling thread and the threads it spawns (see PerfCounters)
+  bool perf_counters;
+  /// Design used for the inputs of the training samples, uniform if null.
+  /// Test points are always drawn uniformly
+  std::shared_ptr<const SamplingDesign> sampling_design;
+  /// Store test points and predictions in single precision, data is converted
+  /// to double precision only when the approximator requires it. Trainers
+  /// require double precision, hence training samples are rounded to single
+  /// precision but stored in double precision
+  bool single_precision;
+  /// Repeat each phase until its median duration is stable (see TimingOptions),
+  /// reported times are then medians
+  bool rigorous_timing;
+  TimingOptions timing;
+};
+
+/// Results of runBenchmark, all times are in seconds
+struct BenchmarkResult
+{
+  BenchmarkResult();
+
+  double smse;
+  double learning_time;
+  double prediction_time;
+  double arg_max_loss;
+  double max_prediction_error;
+  double compute_max_time;
+  /// Time spent generating the training and the test samples
+  double sampling_time;
+  /// Time spent evaluating the function at the input returned by getMaximum
+  double max_evaluation_time;
+  /// Memory used to store samples, test points and predictions [bytes], each
+  /// one is counted with the precision it is actually stored in
+  long data_bytes;
+  /// Time spent by the evaluators of an ExpensiveFunction for the training
+  /// set, the test set and the maximum, -1 for other functions. If phases are
+  /// repeated, the sampling run reported is the one closest to the median
+  double function_time;
+  /// Hardware counters of each phase (see getBenchmarkPhases)
+  /// Empty if perf_counters has not been requested
+  std::map<std::string, PerfValues> counters;
+  /// Summary of the repeated measures of each phase
+  /// Empty if rigorous_timing has not been requested
+  std::map<std::string, TimingSummary> timings;
+};
+
+/// Name of the phases of runBenchmark in chronological order
+std::vector<std::string> getBenchmarkPhases();
+
+/// Read a map name -> trainer from the child 'key' of node, nb_threads is set
+/// for all the trainers
+std::map<std::string, std::shared_ptr<const rosban_fa::Trainer>>
+readTrainers(TiXmlNode * node, const std::string & key, int nb_threads);
+
+/// Read a map name -> benchmark function from the child 'key' of node
+std::map<std::string, std::shared_ptr<const BenchmarkFunction>>
+readFunctions(TiXmlNode * node, const std::string & key);
+
+/// Build a copy of 'prototype' with the given number of input dimensions, the
+/// function has to read 'nb_dimensions' from its xml description
+std::unique_ptr<BenchmarkFunction> buildWithDimensions(const BenchmarkFunction & prototype,
+                                                       int nb_dimensions);
+
+/// Read a map name -> sampling design from the child 'key' of node
+std::map<std::string, std::shared_ptr<const SamplingDesign>>
+readSamplingDesigns(TiXmlNode * node, const std::string & key);
+
 /// Return a matrix containing product(samples_by_dim) columns and limits.rows() rows
 /// Each column is a different sample
 Eigen::MatrixXd discretizeSpace(const Eigen::MatrixXd & limits,
@@ -31,11 +110,30 @@ void buildPrediction(const std::string & function_name,
                      Eigen::VectorXd & prediction_vars,
                      Eigen::MatrixXd & gradients);
 
+/// Same as previous, but predictions are computed on a grid refined where the
+/// approximation changes (see buildAdaptivePrediction), points are not ordered
+void buildPrediction(const std::string & function_name,
+                     int nb_samples,
+                     const std::string & trainer_name,
+                     const RefinementConfig & refinement,
+                     Eigen::MatrixXd & samples_inputs,
+                     Eigen::VectorXd & samples_outputs,
+                     Eigen::MatrixXd & prediction_points,
+                     Eigen::VectorXd & prediction_means,
+                     Eigen::VectorXd & prediction_vars,
+                     Eigen::MatrixXd & gradients);
+
 void predict(std::shared_ptr<const rosban_fa::FunctionApproximator> fa,
              const Eigen::MatrixXd & points,
              Eigen::VectorXd & prediction_means,
              Eigen::VectorXd & prediction_vars);
 
+/// Single precision version, points are converted one at a time
+void predict(std::shared_ptr<const rosban_fa::FunctionApproximator> fa,
+             const Eigen::MatrixXf & points,
+             Eigen::VectorXf & prediction_means,
+             Eigen::VectorXf & prediction_vars);
+
 /// 1. Generate learning and test samples for the given function
 /// 2. Create a regression model using the chosen trainer and the generated samples
 /// 3. Evaluate the quality of the regression model using the test set
@@ -64,6 +162,19 @@ void runBenchmark(std::shared_ptr<const BenchmarkFunction> function,
                   double & compute_max_time,
                   std::default_random_engine * engine);
 
+/// Same as above, but samples are generated from the given stream:
+/// - Training samples use purpose 'TrainingSamples'
+/// - Test samples use purpose 'TestSamples'
+void runBenchmark(std::shared_ptr<const BenchmarkFunction> function,
+                  int nb_samples,
+                  std::shared_ptr<const rosban_fa::Trainer> trainer,
+                  int nb_test_points,
+                  const RandomStream & stream,
+                  const BenchmarkOptions & options,
+                  BenchmarkResult & result);
+
+/// Write observations and predictions to a csv file, all input dimensions and
+/// the full gradient are written (see PredictionExporter)
 void writePrediction(const std::string & path,
                      const Eigen::MatrixXd & samples_inputs,
                      const Eigen::VectorXd & samples_outputs,
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace regression_experiments
+{
+
+/// Records begin/end events in per-thread buffers and writes them at the end
+/// in the Chrome trace-event JSON format (chrome://tracing, ui.perfetto.dev)
+///
+/// Each thread has its own lane, events are appended to the buffer of the
+/// calling thread without any lock. When recording is disabled, the only
+/// cost of an event is the check of an atomic flag.
+class TraceRecorder
+{
+public:
+  /// Metadata attached to an event: (key, value)
+  typedef std::vector<std::pair<std::string, std::string>> Args;
+
+  static TraceRecorder & getInstance();
+
+  void enable();
+  bool isEnabled() const;
+
+  /// Record the beginning of an event on the lane of the calling thread
+  void begin(const std::string & name, const std::string & category,
+             const Args & args = Args());
+  /// Record the end of the last event opened on the lane of the calling thread
+  void end(const std::string & name, const std::string & category);
+
+  /// Name the lane of the calling thread
+  void setThreadName(const std::string & name);
+
+  /// Write all the events recorded so far, must not be called while other
+  /// threads are recording events
+  void writeJson(const std::string & path) const;
+
+private:
+  struct Event
+  {
+    /// 'B' or 'E'
+    char phase;
+    std::string name;
+    std::string category;
+    /// Time since the creation of the recorder [us]
+    double timestamp;
+    Args args;
+  };
+
+  struct ThreadBuffer
+  {
+    int tid;
+    std::string thread_name;
+    std::vector<Event> events;
+  };
+
+  TraceRecorder();
+
+  /// Return the buffer of the calling thread, creating it if necessary
+  ThreadBuffer & getThreadBuffer();
+
+  /// Append an event to the buffer of the calling thread
+  void record(char phase, const std::string & name, const std::string & category,
+              const Args & args);
+
+  std::atomic<bool> enabled;
+  std::chrono::steady_clock::time_point start;
+  /// Protects the list of buffers (not their content)
+  std::mutex buffers_mutex;
+  std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+};
+
+/// Escape a string for a JSON document
+std::string escapeJson(const std::string & str);
+
+/// Record an event spanning the lifetime of the object
+class TraceScope
+{
+public:
+  TraceScope(const std::string & name, const std::string & category,
+             const TraceRecorder::Args & args = TraceRecorder::Args());
+  ~TraceScope();
+
+  TraceScope(const TraceScope & other) = delete;
+  TraceScope & operator=(const TraceScope & other) = delete;
+
+private:
+  /// Was recording enabled when the event started
+  bool active;
+  std::string name;
+  std::string category;
+};
+
+}
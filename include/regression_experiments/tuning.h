@@ -0,0 +1,116 @@
+#pragma once
+
+#include "regression_experiments/counter_rng.h"
+
+#include "rosban_fa/trainer.h"
+
+#include "rosban_utils/serializable.h"
+
+#include <Eigen/Core>
+
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace regression_experiments
+{
+
+/// Values of the parameters of a trainer: tag -> value
+typedef std::map<std::string, std::string> ParameterValues;
+
+/// The values tested for the parameters of a trainer
+///
+/// Each candidate is a trainer node containing one tag per fixed parameter
+/// and per tuned parameter, all other parameters keep their default value.
+class ParameterSpace : public rosban_utils::Serializable
+{
+public:
+  /// All the combinations of the tuned values
+  std::vector<ParameterValues> getGrid() const;
+
+  /// nb_candidates distinct combinations drawn uniformly using 'stream', less
+  /// candidates are returned if the grid is smaller
+  std::vector<ParameterValues> getRandomCandidates(int nb_candidates,
+                                                   const RandomStream & stream) const;
+
+  /// Build a trainer using the provided values for the tuned parameters
+  std::unique_ptr<rosban_fa::Trainer> buildTrainer(const ParameterValues & values,
+                                                   int nb_threads) const;
+
+  /// Xml node of the trainer for the provided values
+  std::string getTrainerXml(const ParameterValues & values) const;
+
+  /// 'tag=value' pairs separated by ';'
+  static std::string toString(const ParameterValues & values);
+
+  virtual std::string class_name() const override;
+  virtual void to_xml(std::ostream &out) const override;
+  virtual void from_xml(TiXmlNode *node) override;
+
+private:
+  /// Class name of the trainer (e.g. 'GPForestTrainer')
+  std::string trainer_name;
+  /// Parameters shared by all the candidates: tag -> value
+  ParameterValues fixed;
+  /// Tuned parameters: tag -> values
+  std::map<std::string, std::vector<std::string>> parameters;
+};
+
+/// A fold of k-fold cross-validation, built once and shared read-only
+struct CrossValidationFold
+{
+  Eigen::MatrixXd training_inputs;
+  Eigen::VectorXd training_observations;
+  Eigen::MatrixXd validation_inputs;
+  Eigen::VectorXd validation_observations;
+};
+
+/// Sample i is in the validation set of fold (i % nb_folds), samples are
+/// expected to be drawn independently
+std::vector<CrossValidationFold> buildFolds(const Eigen::MatrixXd & inputs,
+                                            const Eigen::VectorXd & observations,
+                                            int nb_folds);
+
+/// Scores of a trainer on a fold, times in seconds
+struct FoldScore
+{
+  double smse;
+  double learning_time;
+  /// Total time spent predicting the validation set
+  double prediction_time;
+};
+
+/// A configuration evaluated during the tuning
+struct TuningCandidate
+{
+  TuningCandidate();
+
+  ParameterValues values;
+  std::shared_ptr<const rosban_fa::Trainer> trainer;
+  /// Scores on the first folds, in fold order
+  std::vector<FoldScore> scores;
+  /// Rung at which the candidate has been discarded, -1 if it has not
+  int pruned_rung;
+
+  double getMeanSMSE() const;
+  double getMeanLearningTime() const;
+  double getMeanPredictionTime() const;
+};
+
+/// Evaluate the candidates with successive halving: at each rung, surviving
+/// candidates are evaluated on more folds and only the best (1 / eta) of them
+/// are kept, according to their mean smse. The last rung uses all the folds.
+/// Each rung evaluates strictly more folds than the previous one, rungs which
+/// would not add any fold are merged.
+/// If eta < 2, all candidates are evaluated on all the folds. Candidates
+/// throwing a runtime_error get an infinite smse on the fold.
+///
+/// (candidate, fold) evaluations of a rung are run on nb_workers threads.
+/// Return the index of the best candidate among those evaluated on all folds.
+int runSuccessiveHalving(std::vector<TuningCandidate> & candidates,
+                         const std::vector<CrossValidationFold> & folds,
+                         const Eigen::MatrixXd & limits,
+                         double eta,
+                         int nb_workers);
+
+}
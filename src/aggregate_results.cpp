@@ -0,0 +1,38 @@
+#include "regression_experiments/result_aggregator.h"
+
+#include <cstdlib>
+#include <iostream>
+
+using namespace regression_experiments;
+
+int main(int argc, char ** argv)
+{
+  if (argc < 2) {
+    std::cerr << "Usage: " << argv[0] << " [-o <output_prefix>] <result_files>..." << std::endl
+              << "Writes <output_prefix>summary.csv and <output_prefix>pareto.csv" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  std::string prefix("");
+  std::vector<std::string> paths;
+  for (int i = 1; i < argc; i++) {
+    std::string arg(argv[i]);
+    if (arg == "-o" && i + 1 < argc) {
+      prefix = argv[++i];
+    }
+    else {
+      paths.push_back(arg);
+    }
+  }
+
+  ResultAggregator aggregator;
+  for (const std::string & path : paths) {
+    std::cout << "Reading '" << path << "'" << std::endl;
+    aggregator.addFile(path);
+  }
+  std::cout << aggregator.getNbLines() << " lines read" << std::endl;
+
+  aggregator.writeSummary(prefix + "summary.csv");
+  aggregator.writeParetoFront(prefix + "pareto.csv",
+                              {{"smse", "learning_time"},
+                               {"smse", "prediction_time"}});
+}
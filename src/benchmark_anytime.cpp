@@ -0,0 +1,122 @@
+#include "regression_experiments/anytime_profile.h"
+#include "regression_experiments/tools.h"
+
+#include "rosban_utils/time_stamp.h"
+
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <random>
+
+using namespace regression_experiments;
+
+using rosban_fa::Trainer;
+using rosban_fa::FunctionApproximator;
+using rosban_utils::TimeStamp;
+
+class AnytimeConfig : public rosban_utils::Serializable
+{
+public:
+  /// Which trainers are used? name -> trainer
+  std::map<std::string, std::shared_ptr<const Trainer>> methods;
+  /// Which functions are used? name -> function
+  std::map<std::string, std::shared_ptr<const BenchmarkFunction>> functions;
+  /// Number of samples used for training
+  std::vector<int> nb_samples;
+  /// Number of predictions after which the best candidate is evaluated
+  std::vector<int> evaluation_budgets;
+  /// Time [s] after which the best candidate is evaluated
+  std::vector<double> time_budgets;
+  /// How many trials are used for each combination (method, nb_samples, function)
+  int nb_trials;
+  /// Number of threads allowed for each method
+  int nb_threads;
+  /// Seed of the random streams, drawn randomly if not provided
+  uint32_t seed;
+
+  std::string class_name() const override
+    {
+      return "anytime_config";
+    }
+
+  void to_xml(std::ostream &out) const override
+    {
+      (void) out;
+      throw std::logic_error("AnytimeConfig::to_xml: Not implemented");
+    }
+
+  void from_xml(TiXmlNode *node)
+    {
+      nb_threads = rosban_utils::xml_tools::read<int>(node, "nb_threads");
+      nb_trials  = rosban_utils::xml_tools::read<int>(node, "nb_trials" );
+      nb_samples = rosban_utils::xml_tools::read_vector<int>(node, "nb_samples");
+      rosban_utils::xml_tools::try_read_vector<int>   (node, "evaluation_budgets", evaluation_budgets);
+      rosban_utils::xml_tools::try_read_vector<double>(node, "time_budgets"      , time_budgets      );
+      int read_seed = -1;
+      rosban_utils::xml_tools::try_read<int>(node, "seed", read_seed);
+      seed = read_seed >= 0 ? (uint32_t)read_seed : std::random_device()();
+      // Read methods and functions
+      methods = readTrainers(node, "methods", nb_threads);
+      functions = readFunctions(node, "functions");
+    }
+};
+
+int main()
+{
+  AnytimeConfig conf;
+  conf.load_file();
+
+  std::cout << "Using seed: " << conf.seed << std::endl;
+
+  std::ofstream out;
+  out.open("benchmark_anytime.csv");
+  out << "function_name,method,nb_samples,trial,learning_time,"
+      << "budget_type,budget,nb_evaluations,search_time,expected_max,arg_max_loss"
+      << std::endl;
+
+  int function_id = -1;
+  for (auto & function_entry : conf.functions) {
+    function_id++;
+    const std::string & function_name = function_entry.first;
+    std::shared_ptr<const BenchmarkFunction> function = function_entry.second;
+    for (auto & method_entry : conf.methods) {
+      const std::string & method_name = method_entry.first;
+      std::shared_ptr<const Trainer> trainer = method_entry.second;
+      for (size_t samples_id = 0; samples_id < conf.nb_samples.size(); samples_id++) {
+        int nb_samples = conf.nb_samples[samples_id];
+        uint32_t cell = function_id * conf.nb_samples.size() + samples_id;
+        std::cout << "Profiling '" << function_name << "' with '" << method_name
+                  << "' (" << nb_samples << " samples)" << std::endl;
+        for (int trial = 1; trial <= conf.nb_trials; trial++) {
+          RandomStream stream(conf.seed, cell, trial);
+          Eigen::MatrixXd samples_inputs;
+          Eigen::VectorXd samples_outputs;
+          function->getUniformSamples(nb_samples, samples_inputs, samples_outputs,
+                                      stream.withPurpose(RandomPurpose::TrainingSamples),
+                                      true, conf.nb_threads);
+          TimeStamp learning_start = TimeStamp::now();
+          std::shared_ptr<const FunctionApproximator> fa;
+          fa = trainer->train(samples_inputs, samples_outputs, function->getLimits());
+          double learning_time = diffSec(learning_start, TimeStamp::now());
+          std::vector<AnytimePoint> profile;
+          profile = runAnytimeProfile(function, fa,
+                                      conf.evaluation_budgets, conf.time_budgets,
+                                      stream.withPurpose(RandomPurpose::MaxSearch));
+          for (const AnytimePoint & point : profile) {
+            out << function_name        << ","
+                << method_name          << ","
+                << nb_samples           << ","
+                << trial                << ","
+                << learning_time        << ","
+                << point.budget_type    << ","
+                << point.budget         << ","
+                << point.nb_evaluations << ","
+                << point.elapsed_time   << ","
+                << point.expected_max   << ","
+                << point.arg_max_loss   << std::endl;
+          }
+        }
+      }
+    }
+  }
+}
@@ -1,15 +1,22 @@
 #include "regression_experiments/benchmark_function_factory.h"
+#include "regression_experiments/expensive_function.h"
+#include "regression_experiments/placement.h"
+#include "regression_experiments/progress_monitor.h"
+#include "regression_experiments/random_function.h"
 #include "regression_experiments/tools.h"
+#include "regression_experiments/trace_recorder.h"
 
 #include "rosban_regression_forests/algorithms/extra_trees.h"
 #include "rosban_regression_forests/approximations/gp_approximation.h"
 
 #include "rosban_fa/trainer_factory.h"
 
-#include "rosban_random/tools.h"
-
+#include <atomic>
 #include <fstream>
 #include <map>
+#include <mutex>
+#include <random>
+#include <thread>
 
 using namespace regression_experiments;
 
@@ -23,7 +30,14 @@ public:
   /// Which trainers are used? name -> trainer
   std::map<std::string, std::shared_ptr<const Trainer>> methods;
   /// Which functions are used for benchmark? name -> function
+  /// Functions of the optional 'random_suite' are added to this map
   std::map<std::string, std::shared_ptr<const BenchmarkFunction>> functions;
+  /// Designs used for the training samples: name -> design
+  /// If empty, training samples are drawn uniformly
+  std::map<std::string, std::shared_ptr<const SamplingDesign>> sampling_designs;
+  /// If positive, the number of samples required by each (function, method,
+  /// design) to reach an average smse below this value is reported
+  double smse_target;
   /// What is the minimal number of samples?
   int min_samples;
   /// How many points are used to evaluate smse
@@ -40,7 +54,32 @@ public:
   double max_compute_max_time;
   /// Number of threads allowed for each method
   int nb_threads;
-  
+  /// Number of (function, method) pairs processed simultaneously
+  int nb_workers;
+  /// Placement of the workers: 'none', 'compact', 'spread' or 'numa_node'
+  /// with 'numa_node', there is one worker per NUMA node
+  std::string placement;
+  /// Should hardware performance counters be collected for each phase?
+  bool perf_counters;
+  /// If not empty, a Chrome trace of the benchmark is written at this path
+  std::string trace_path;
+  /// If not empty, the progress of the benchmark is periodically written at this path
+  std::string status_path;
+  /// If not empty, the progress is also served on a Unix socket at this path
+  std::string status_socket;
+  /// Time between two updates of the status file [s]
+  double status_period;
+  /// Seed of the random streams, drawn randomly if not provided
+  uint32_t seed;
+  /// Storage of samples, test points and predictions: 'double', 'float' or
+  /// 'both' to run each cell in both modes and compare them
+  std::string precision;
+  /// If true, each phase is repeated until its median duration is stable and
+  /// reported times are medians (enabled by the optional 'timing' node, forces
+  /// a single worker)
+  bool rigorous_timing;
+  TimingOptions timing;
+
   std::string class_name() const override
     {
       return "benchmark_config";
@@ -62,25 +101,69 @@ public:
       max_learning_time    = rosban_utils::xml_tools::read<double>(node, "max_learning_time"   );
       max_prediction_time  = rosban_utils::xml_tools::read<double>(node, "max_prediction_time" );
       max_compute_max_time = rosban_utils::xml_tools::read<double>(node, "max_compute_max_time");
-      // Read methods
-      TrainerFactory tf;
-      std::function<std::shared_ptr<const Trainer>(TiXmlNode*)> trainer_builder;
-      trainer_builder = [this, &tf](TiXmlNode * node)
-        {
-          std::unique_ptr<Trainer> trainer = tf.build(node);
-          trainer->setNbThreads(this->nb_threads);
-          return std::move(trainer);
-        };
-      methods = rosban_utils::xml_tools::read_map(node, "methods", trainer_builder);
-      // Read functions
-      BenchmarkFunctionFactory bff;
-      std::function<std::shared_ptr<const BenchmarkFunction>(TiXmlNode*)> bf_builder;
-      bf_builder = [&bff](TiXmlNode * node)
-        { return std::shared_ptr<BenchmarkFunction>(bff.build(node)); };
-      functions = rosban_utils::xml_tools::read_map(node, "functions", bf_builder);
+      nb_workers = 1;
+      placement = "none";
+      rosban_utils::xml_tools::try_read<int>        (node, "nb_workers", nb_workers);
+      rosban_utils::xml_tools::try_read<std::string>(node, "placement" , placement );
+      perf_counters = false;
+      rosban_utils::xml_tools::try_read<bool>(node, "perf_counters", perf_counters);
+      rosban_utils::xml_tools::try_read<std::string>(node, "trace_path", trace_path);
+      status_period = 5;
+      rosban_utils::xml_tools::try_read<std::string>(node, "status_path"  , status_path  );
+      rosban_utils::xml_tools::try_read<std::string>(node, "status_socket", status_socket);
+      rosban_utils::xml_tools::try_read<double>     (node, "status_period", status_period);
+      precision = "double";
+      rosban_utils::xml_tools::try_read<std::string>(node, "precision", precision);
+      if (precision != "double" && precision != "float" && precision != "both") {
+        throw std::runtime_error("BenchmarkConfig: unknown precision '" + precision + "'");
+      }
+      rigorous_timing = node->FirstChild("timing") != nullptr;
+      if (rigorous_timing) {
+        timing.read(node, "timing");
+      }
+      int read_seed = -1;
+      rosban_utils::xml_tools::try_read<int>(node, "seed", read_seed);
+      seed = read_seed >= 0 ? (uint32_t)read_seed : std::random_device()();
+      // Read methods and functions
+      methods = readTrainers(node, "methods", nb_threads);
+      if (node->FirstChild("functions") != nullptr) {
+        functions = readFunctions(node, "functions");
+      }
+      TiXmlNode * suite_node = node->FirstChild("random_suite");
+      if (suite_node != nullptr) {
+        int nb_functions = rosban_utils::xml_tools::read<int>(suite_node, "nb_functions");
+        int first_seed = 0;
+        rosban_utils::xml_tools::try_read<int>(suite_node, "first_seed", first_seed);
+        RandomFunction prototype;
+        prototype.read(suite_node, "random_function");
+        for (auto & entry : buildRandomSuite(prototype, nb_functions, first_seed)) {
+          if (!functions.insert(entry).second) {
+            throw std::runtime_error("BenchmarkConfig: function '" + entry.first + "' defined twice");
+          }
+        }
+      }
+      if (functions.empty()) {
+        throw std::runtime_error("BenchmarkConfig: no functions");
+      }
+      if (node->FirstChild("sampling_designs") != nullptr) {
+        sampling_designs = readSamplingDesigns(node, "sampling_designs");
+      }
+      smse_target = -1;
+      rosban_utils::xml_tools::try_read<double>(node, "smse_target", smse_target);
     }
 };
 
+struct BenchmarkTask
+{
+  int function_id;
+  std::string function_name;
+  std::shared_ptr<const BenchmarkFunction> function;
+  std::string method_name;
+  std::shared_ptr<const Trainer> trainer;
+  std::string design_name;
+  std::shared_ptr<const SamplingDesign> design;
+};
+
 int main()
 {
   BenchmarkConfig conf;
@@ -91,82 +174,361 @@ int main()
     nb_samples_vec.push_back(conf.min_samples * std::pow(2,i-1));
   }
 
-  // Creating random engine
-  auto engine = rosban_random::getRandomEngine();
+  // Each (function, nb_samples) is a cell of the random streams, therefore all
+  // methods are trained and tested on the same samples
+  std::cout << "Using seed: " << conf.seed << std::endl;
+
+  BenchmarkOptions options;
+  options.nb_threads = conf.nb_threads;
+  options.perf_counters = conf.perf_counters;
+  options.rigorous_timing = conf.rigorous_timing;
+  options.timing = conf.timing;
+  if (conf.perf_counters && !PerfCounters().isAvailable()) {
+    std::cerr << "Performance counters are unavailable, values will be -1" << std::endl;
+  }
+  if (conf.trace_path != "") {
+    TraceRecorder::getInstance().enable();
+    TraceRecorder::getInstance().setThreadName("main");
+  }
+
+  // Placement of the workers, all threads of a worker stay on its cpus
+  PlacementPolicy placement_policy = parsePlacementPolicy(conf.placement);
+  CpuTopology topology = CpuTopology::detect();
+  int nb_workers = conf.nb_workers;
+  if (placement_policy == PlacementPolicy::NumaNode) {
+    nb_workers = topology.getNbNodes();
+  }
+  if (conf.rigorous_timing && nb_workers > 1) {
+    // Concurrent workers would disturb each other's repeated measures
+    std::cerr << "Repeated timing requires a single worker, using 1 instead of "
+              << nb_workers << std::endl;
+    nb_workers = 1;
+  }
+  std::vector<WorkerPlacement> placements;
+  placements = computePlacement(topology, placement_policy, nb_workers, conf.nb_threads);
+  {
+    // Recording the topology used, so that timings can be compared between runs
+    std::ofstream placement_out("benchmark_regression_placement.csv");
+    placement_out << "policy,topology,worker,numa_node,cpus" << std::endl;
+    for (int worker_id = 0; worker_id < nb_workers; worker_id++) {
+      placement_out << toString(placement_policy) << ","
+                    << "\"" << topology.toString() << "\","
+                    << worker_id << ","
+                    << placements[worker_id].numa_node << ","
+                    << "\"" << cpusToString(placements[worker_id].cpus) << "\"" << std::endl;
+    }
+  }
 
   // Open and write header for regression benchmark
   std::ofstream out;
   out.open("benchmark_regression.csv");
+  bool has_designs = !conf.sampling_designs.empty();
+  // Evaluation time is reported only for expensive functions
+  bool has_expensive = false;
+  for (const auto & entry : conf.functions) {
+    if (dynamic_cast<const ExpensiveFunction *>(entry.second.get()) != nullptr) {
+      has_expensive = true;
+    }
+  }
   out << "function_name,"
-      << "method,"
-      << "nb_samples,"
+      << "method,";
+  if (has_designs) {
+    out << "design,";
+  }
+  if (conf.precision != "double") {
+    out << "precision,";
+  }
+  out << "nb_samples,"
       << "smse,"
       << "learning_time,"
       << "prediction_time";
+  if (has_expensive) {
+    out << ",function_time";
+  }
   if (conf.eval_max) {
     out << ",squared_loss,squared_error,compute_max_time";
   }
+  if (conf.perf_counters) {
+    for (const std::string & phase : getBenchmarkPhases()) {
+      out << "," << PerfValues::csvHeader(phase + "_");
+    }
+  }
+  if (placement_policy != PlacementPolicy::None) {
+    out << ",worker,numa_node";
+  }
   out << std::endl;
 
+  std::vector<bool> precisions;
+  if (conf.precision != "float") precisions.push_back(false);
+  if (conf.precision != "double") precisions.push_back(true);
+  // Comparison of both modes on the same cells
+  std::ofstream precision_out;
+  if (conf.precision == "both") {
+    precision_out.open("benchmark_regression_precision.csv");
+    precision_out << "function_name,method,design,nb_samples,trial,"
+                  << "smse_double,smse_float,smse_delta,arg_max_loss_delta,"
+                  << "data_bytes_double,data_bytes_float,"
+                  << "prediction_throughput_double,prediction_throughput_float,"
+                  << "sampling_time_double,sampling_time_float" << std::endl;
+  }
+
+  // Confidence intervals of each repeated phase, and every measure along with
+  // the machine state captured right after it
+  std::ofstream timing_out, measure_out;
+  if (conf.rigorous_timing) {
+    timing_out.open("benchmark_regression_timings.csv");
+    timing_out << "function_name,method,design,precision,nb_samples,trial,phase,"
+               << TimingSummary::csvHeader("") << std::endl;
+    measure_out.open("benchmark_regression_timing_measures.csv");
+    measure_out << "function_name,method,design,precision,nb_samples,trial,phase,"
+                << "run,duration," << MachineState::csvHeader("") << std::endl;
+  }
+
+  // Without designs, a single uniform design is used
+  std::map<std::string, std::shared_ptr<const SamplingDesign>> designs = conf.sampling_designs;
+  if (!has_designs) {
+    designs["uniform"] = nullptr;
+  }
+
+  // A task is the samples ladder of a (function, method, design) triplet
+  std::vector<BenchmarkTask> tasks;
+  int function_id = -1;
   for (auto & function_entry : conf.functions) {
-    const std::string & function_name = function_entry.first;
-    std::shared_ptr<const BenchmarkFunction> function = function_entry.second;
+    function_id++;
     for (auto & method_entry : conf.methods) {
-      const std::string & method_name = method_entry.first;
-      std::shared_ptr<const Trainer> trainer = method_entry.second;
-      for (int nb_samples : nb_samples_vec) {
-        std::cout << "Fitting '" << function_name << "' with '" << method_name
-                  << "' (" << nb_samples << " samples)" << std::endl;
-        double total_prediction_time = 0;
-        double total_learning_time   = 0;
-        double total_max_time        = 0;
-        for (int trial = 1; trial <= conf.nb_trials_per_type; trial++) {
-          std::cerr << "\ttrial: " << trial << "/" << conf.nb_trials_per_type << std::endl;
-          double smse, learning_time, prediction_time;
-          double arg_max_loss, max_prediction_error, compute_max_time;
-          runBenchmark(function,
-                       nb_samples,
-                       trainer,
-                       conf.nb_prediction_points,
-                       smse,
-                       learning_time,
-                       prediction_time,
-                       arg_max_loss,
-                       max_prediction_error,
-                       compute_max_time,
-                       &engine);
-          // prediction time per point
-          prediction_time /= conf.nb_prediction_points;
-
-          double loss2, error2;
-          loss2 = arg_max_loss * arg_max_loss;
-          error2 = max_prediction_error * max_prediction_error;
-          out << function_name   << ","
-              << method_name     << ","
-              << nb_samples      << ","
-              << smse            << ","
-              << learning_time   << ","
-              << prediction_time;
-          if (conf.eval_max) {
-            out << "," << loss2
-                << "," << error2
-                << "," << (learning_time + compute_max_time);
+      for (auto & design_entry : designs) {
+        BenchmarkTask task;
+        task.function_id = function_id;
+        task.function_name = function_entry.first;
+        task.function = function_entry.second;
+        task.method_name = method_entry.first;
+        task.trainer = method_entry.second;
+        task.design_name = design_entry.first;
+        task.design = design_entry.second;
+        tasks.push_back(task);
+      }
+    }
+  }
+  // Number of samples required to reach smse_target for each task, -1 if not reached
+  std::vector<int> samples_to_target(tasks.size(), -1);
+
+  // A cell of the progress is a single run of runBenchmark, cells are grouped
+  // by method for the cost models
+  int runs_per_size = conf.nb_trials_per_type * precisions.size();
+  ProgressMonitor monitor(nb_workers);
+  for (const BenchmarkTask & task : tasks) {
+    for (int nb_samples : nb_samples_vec) {
+      monitor.plan(task.method_name, nb_samples, runs_per_size);
+    }
+  }
+  if (conf.status_path != "" || conf.status_socket != "") {
+    monitor.start(conf.status_path, conf.status_socket, conf.status_period);
+  }
+
+  std::mutex output_mutex;
+  std::atomic<int> next_task(0);
+  auto worker = [&](int worker_id)
+    {
+      const WorkerPlacement & placement = placements[worker_id];
+      if (!applyPlacement(placement)) {
+        std::lock_guard<std::mutex> lock(output_mutex);
+        std::cerr << "Worker " << worker_id << ": failed to apply placement" << std::endl;
+      }
+      TraceRecorder::getInstance().setThreadName("worker_" + std::to_string(worker_id));
+      while (true) {
+        int task_id = next_task++;
+        if (task_id >= (int)tasks.size()) break;
+        const BenchmarkTask & task = tasks[task_id];
+        const std::string & function_name = task.function_name;
+        const std::string & method_name = task.method_name;
+        BenchmarkOptions task_options = options;
+        task_options.sampling_design = task.design;
+        for (size_t samples_id = 0; samples_id < nb_samples_vec.size(); samples_id++) {
+          int nb_samples = nb_samples_vec[samples_id];
+          uint32_t cell = task.function_id * nb_samples_vec.size() + samples_id;
+          {
+            std::lock_guard<std::mutex> lock(output_mutex);
+            std::cout << "Fitting '" << function_name << "' with '" << method_name
+                      << "' (" << nb_samples << " samples";
+            if (has_designs) std::cout << ", design: " << task.design_name;
+            std::cout << ")" << std::endl;
+          }
+          double total_prediction_time = 0;
+          double total_learning_time   = 0;
+          double total_max_time        = 0;
+          double total_smse            = 0;
+          for (int trial = 1; trial <= conf.nb_trials_per_type; trial++) {
+            TraceScope cell_trace("cell", "cell",
+                                  {{"function", function_name},
+                                   {"method", method_name},
+                                   {"design", task.design_name},
+                                   {"nb_samples", std::to_string(nb_samples)},
+                                   {"trial", std::to_string(trial)}});
+            // With 'both', the same cell is run in double then in single precision
+            std::vector<BenchmarkResult> results;
+            for (bool single_precision : precisions) {
+              task_options.single_precision = single_precision;
+              std::ostringstream description;
+              description << function_name << "/" << method_name << "/" << task.design_name
+                          << "/" << nb_samples << "/trial_" << trial
+                          << (single_precision ? "/float" : "");
+              monitor.startCell(worker_id, method_name, nb_samples, description.str());
+              BenchmarkResult result;
+              runBenchmark(task.function,
+                           nb_samples,
+                           task.trainer,
+                           conf.nb_prediction_points,
+                           RandomStream(conf.seed, cell, trial),
+                           task_options,
+                           result);
+              monitor.endCell(worker_id);
+              double learning_time = result.learning_time;
+              double compute_max_time = result.compute_max_time;
+              // prediction time per point
+              double prediction_time = result.prediction_time / conf.nb_prediction_points;
+              // time spent by the pool evaluating the function for this cell, -1
+              // for functions which are not expensive
+              double function_time = result.function_time;
+
+              TraceScope write_trace("write", "phase");
+              double loss2, error2;
+              loss2 = result.arg_max_loss * result.arg_max_loss;
+              error2 = result.max_prediction_error * result.max_prediction_error;
+              std::ostringstream line;
+              line << function_name   << ","
+                   << method_name     << ",";
+              if (has_designs) {
+                line << task.design_name << ",";
+              }
+              if (conf.precision != "double") {
+                line << (single_precision ? "float" : "double") << ",";
+              }
+              line << nb_samples      << ","
+                   << result.smse     << ","
+                   << learning_time   << ","
+                   << prediction_time;
+              if (has_expensive) {
+                line << "," << function_time;
+              }
+              if (conf.eval_max) {
+                line << "," << loss2
+                     << "," << error2
+                     << "," << (learning_time + compute_max_time);
+              }
+              if (conf.perf_counters) {
+                for (const std::string & phase : getBenchmarkPhases()) {
+                  line << ",";
+                  result.counters[phase].writeCsv(line);
+                }
+              }
+              if (placement_policy != PlacementPolicy::None) {
+                line << "," << worker_id << "," << placement.numa_node;
+              }
+              {
+                std::lock_guard<std::mutex> lock(output_mutex);
+                out << line.str() << std::endl;
+                for (const auto & entry : result.timings) {
+                  std::ostringstream key;
+                  key << function_name << ","
+                      << method_name << ","
+                      << task.design_name << ","
+                      << (single_precision ? "float" : "double") << ","
+                      << nb_samples << ","
+                      << trial << ","
+                      << entry.first << ",";
+                  timing_out << key.str();
+                  entry.second.writeCsv(timing_out);
+                  timing_out << std::endl;
+                  const TimingSummary & summary = entry.second;
+                  for (size_t run = 0; run < summary.measures.size(); run++) {
+                    measure_out << key.str() << run << "," << summary.measures[run] << ",";
+                    summary.machines[run].writeCsv(measure_out);
+                    measure_out << std::endl;
+                  }
+                }
+              }
+              results.push_back(result);
+            }
+            {
+              std::lock_guard<std::mutex> lock(output_mutex);
+              std::cerr << "\ttrial: " << trial << "/" << conf.nb_trials_per_type
+                        << " (" << function_name << ", " << method_name << ")" << std::endl;
+            }
+            if (results.size() == 2) {
+              const BenchmarkResult & d = results[0];
+              const BenchmarkResult & f = results[1];
+              std::lock_guard<std::mutex> lock(output_mutex);
+              precision_out << function_name << ","
+                            << method_name << ","
+                            << task.design_name << ","
+                            << nb_samples << ","
+                            << trial << ","
+                            << d.smse << ","
+                            << f.smse << ","
+                            << (f.smse - d.smse) << ","
+                            << (f.arg_max_loss - d.arg_max_loss) << ","
+                            << d.data_bytes << ","
+                            << f.data_bytes << ","
+                            << conf.nb_prediction_points / d.prediction_time << ","
+                            << conf.nb_prediction_points / f.prediction_time << ","
+                            << d.sampling_time << ","
+                            << f.sampling_time << std::endl;
+            }
+            // Ladder and efficiency use the first run
+            const BenchmarkResult & result = results[0];
+            double learning_time = result.learning_time;
+            double compute_max_time = result.compute_max_time;
+            double prediction_time = result.prediction_time / conf.nb_prediction_points;
+            // Cumulating time
+            total_learning_time   += learning_time;
+            total_prediction_time += prediction_time;
+            total_max_time += compute_max_time;
+            total_smse += result.smse;
+          }
+          double avg_learning_time    = total_learning_time   / conf.nb_trials_per_type;
+          double avg_prediction_time  = total_prediction_time / conf.nb_trials_per_type;
+          double avg_max_time         = total_max_time        / conf.nb_trials_per_type;
+          double avg_smse             = total_smse            / conf.nb_trials_per_type;
+          if (samples_to_target[task_id] < 0 && avg_smse <= conf.smse_target) {
+            samples_to_target[task_id] = nb_samples;
+          }
+          // Do not compute with higher number of samples if one of time is
+          // already above the threshold
+          if (avg_learning_time   > conf.max_learning_time    ||
+              avg_prediction_time > conf.max_prediction_time  ||
+              avg_max_time        > conf.max_compute_max_time) {
+            for (size_t next_id = samples_id + 1; next_id < nb_samples_vec.size(); next_id++) {
+              monitor.cancel(method_name, nb_samples_vec[next_id], runs_per_size);
+            }
+            break;
           }
-          out << std::endl;
-          // Cumulating time
-          total_learning_time   += learning_time;
-          total_prediction_time += prediction_time;
-          total_max_time += compute_max_time;
         }
-        double avg_learning_time    = total_learning_time   / conf.nb_trials_per_type;
-        double avg_prediction_time  = total_prediction_time / conf.nb_trials_per_type;
-        double avg_max_time         = total_max_time        / conf.nb_trials_per_type;
-        // Do not compute with higher number of samples if one of time is
-        // already above the threshold
-        if (avg_learning_time   > conf.max_learning_time   ) break;
-        if (avg_prediction_time > conf.max_prediction_time ) break;
-        if (avg_max_time        > conf.max_compute_max_time) break;
       }
+    };
+
+  std::vector<std::thread> workers;
+  for (int worker_id = 0; worker_id < nb_workers; worker_id++) {
+    workers.push_back(std::thread(worker, worker_id));
+  }
+  for (std::thread & thread : workers) {
+    thread.join();
+  }
+  monitor.stop();
+
+  if (conf.smse_target > 0) {
+    std::ofstream efficiency_out("benchmark_regression_efficiency.csv");
+    efficiency_out << "function_name,method,design,smse_target,samples_to_target" << std::endl;
+    for (size_t task_id = 0; task_id < tasks.size(); task_id++) {
+      const BenchmarkTask & task = tasks[task_id];
+      efficiency_out << task.function_name << ","
+                     << task.method_name << ","
+                     << task.design_name << ","
+                     << conf.smse_target << ","
+                     << samples_to_target[task_id] << std::endl;
     }
   }
+
+  if (conf.trace_path != "") {
+    TraceRecorder::getInstance().writeJson(conf.trace_path);
+  }
 }
@@ -0,0 +1,250 @@
+#include "regression_experiments/scaling_law.h"
+#include "regression_experiments/tools.h"
+
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <random>
+
+using namespace regression_experiments;
+
+using rosban_fa::Trainer;
+
+/// Sweep over input dimensions and number of samples: each family is
+/// instantiated at every dimension and each method climbs the samples ladder
+/// until one of the budgets is exceeded. Learning time, prediction latency and
+/// smse are then fitted as c * n^a * d^b for each method. Memory is not fitted:
+/// the resident size of the process does not isolate what a method allocates.
+class ScalingConfig : public rosban_utils::Serializable
+{
+public:
+  /// Which trainers are used? name -> trainer
+  std::map<std::string, std::shared_ptr<const Trainer>> methods;
+  /// Functions instantiated at each dimension: name -> function, the value of
+  /// 'nb_dimensions' of these functions is ignored
+  std::map<std::string, std::shared_ptr<const BenchmarkFunction>> families;
+  /// Input dimensions of the sweep
+  std::vector<int> dimensions;
+  /// Samples ladder: min_samples, 2 * min_samples, ... up to max_samples
+  int min_samples;
+  int max_samples;
+  /// How many points are used to evaluate smse and prediction time
+  int nb_prediction_points;
+  /// How many trials are used for each (family, dimension, method, nb_samples)
+  int nb_trials;
+  /// Maximal learning time [s]
+  double max_learning_time;
+  /// Maximal prediction time per point [s]
+  double max_prediction_time;
+  /// Number of threads allowed for each method
+  int nb_threads;
+  /// Seed of the random streams, drawn randomly if not provided
+  uint32_t seed;
+  /// If true, each phase is repeated until its median duration is stable
+  /// (enabled by the optional 'timing' node)
+  bool rigorous_timing;
+  TimingOptions timing;
+
+  std::string class_name() const override
+    {
+      return "scaling_config";
+    }
+
+  void to_xml(std::ostream &out) const override
+    {
+      (void) out;
+      throw std::logic_error("ScalingConfig::to_xml: Not implemented");
+    }
+
+  void from_xml(TiXmlNode *node)
+    {
+      dimensions           = rosban_utils::xml_tools::read_vector<int>(node, "dimensions");
+      min_samples          = rosban_utils::xml_tools::read<int>   (node, "min_samples"         );
+      max_samples          = rosban_utils::xml_tools::read<int>   (node, "max_samples"         );
+      nb_prediction_points = rosban_utils::xml_tools::read<int>   (node, "nb_prediction_points");
+      nb_trials            = rosban_utils::xml_tools::read<int>   (node, "nb_trials"           );
+      max_learning_time    = rosban_utils::xml_tools::read<double>(node, "max_learning_time"   );
+      max_prediction_time  = rosban_utils::xml_tools::read<double>(node, "max_prediction_time" );
+      nb_threads           = rosban_utils::xml_tools::read<int>   (node, "nb_threads"          );
+      if (dimensions.empty() || min_samples <= 0 || max_samples < min_samples || nb_trials <= 0) {
+        throw std::runtime_error("ScalingConfig: invalid dimensions, samples or trials");
+      }
+      rigorous_timing = node->FirstChild("timing") != nullptr;
+      if (rigorous_timing) {
+        timing.read(node, "timing");
+      }
+      int read_seed = -1;
+      rosban_utils::xml_tools::try_read<int>(node, "seed", read_seed);
+      seed = read_seed >= 0 ? (uint32_t)read_seed : std::random_device()();
+      methods = readTrainers(node, "methods", nb_threads);
+      families = readFunctions(node, "families");
+    }
+};
+
+/// Metrics fitted for each method
+static const std::vector<std::string> metrics =
+{"learning_time", "prediction_time", "smse"};
+
+int main()
+{
+  ScalingConfig conf;
+  conf.load_file();
+
+  std::vector<int> nb_samples_vec;
+  for (int nb_samples = conf.min_samples; nb_samples <= conf.max_samples; nb_samples *= 2) {
+    nb_samples_vec.push_back(nb_samples);
+  }
+  std::cout << "Using seed: " << conf.seed << std::endl;
+
+  // Cells are run one at a time, otherwise timings of a method would depend on
+  // the other methods running simultaneously
+  BenchmarkOptions options;
+  options.nb_threads = conf.nb_threads;
+  options.rigorous_timing = conf.rigorous_timing;
+  options.timing = conf.timing;
+
+  std::ofstream out("benchmark_scaling.csv");
+  out << "family,method,nb_dimensions,nb_samples,trial,"
+      << "smse,learning_time,prediction_time,data_bytes" << std::endl;
+
+  // Observations: method -> family -> metric -> observations
+  typedef std::map<std::string, std::vector<ScalingObservation>> MetricsObservations;
+  std::map<std::string, std::map<std::string, MetricsObservations>> observations;
+  // Largest number of samples within the budgets, 0 if none:
+  // method -> family -> nb_dimensions -> nb_samples
+  std::map<std::string, std::map<std::string, std::map<int, int>>> viable_samples;
+
+  int family_id = -1;
+  for (const auto & family_entry : conf.families) {
+    family_id++;
+    const std::string & family_name = family_entry.first;
+    for (size_t dim_id = 0; dim_id < conf.dimensions.size(); dim_id++) {
+      int nb_dimensions = conf.dimensions[dim_id];
+      std::shared_ptr<const BenchmarkFunction> function =
+        buildWithDimensions(*family_entry.second, nb_dimensions);
+      for (const auto & method_entry : conf.methods) {
+        const std::string & method_name = method_entry.first;
+        MetricsObservations & method_observations = observations[method_name][family_name];
+        int & max_viable = viable_samples[method_name][family_name][nb_dimensions];
+        max_viable = 0;
+        for (size_t samples_id = 0; samples_id < nb_samples_vec.size(); samples_id++) {
+          int nb_samples = nb_samples_vec[samples_id];
+          // All methods are trained and tested on the same samples
+          uint32_t cell = (family_id * conf.dimensions.size() + dim_id) * nb_samples_vec.size()
+            + samples_id;
+          std::cout << "Fitting '" << family_name << "' (" << nb_dimensions << " dimensions) with '"
+                    << method_name << "' (" << nb_samples << " samples)" << std::endl;
+          std::map<std::string, double> totals;
+          for (int trial = 1; trial <= conf.nb_trials; trial++) {
+            BenchmarkResult result;
+            runBenchmark(function,
+                         nb_samples,
+                         method_entry.second,
+                         conf.nb_prediction_points,
+                         RandomStream(conf.seed, cell, trial),
+                         options,
+                         result);
+            std::map<std::string, double> values;
+            values["learning_time"] = result.learning_time;
+            values["prediction_time"] = result.prediction_time / conf.nb_prediction_points;
+            values["smse"] = result.smse;
+            for (const std::string & metric : metrics) {
+              ScalingObservation observation;
+              observation.nb_samples = nb_samples;
+              observation.nb_dimensions = nb_dimensions;
+              observation.value = values[metric];
+              method_observations[metric].push_back(observation);
+              totals[metric] += values[metric];
+            }
+            out << family_name << ","
+                << method_name << ","
+                << nb_dimensions << ","
+                << nb_samples << ","
+                << trial << ","
+                << result.smse << ","
+                << values["learning_time"] << ","
+                << values["prediction_time"] << ","
+                << result.data_bytes << std::endl;
+          }
+          double avg_learning_time   = totals["learning_time"]   / conf.nb_trials;
+          double avg_prediction_time = totals["prediction_time"] / conf.nb_trials;
+          // Do not compute with higher number of samples once a budget is exceeded
+          if (avg_learning_time   > conf.max_learning_time ||
+              avg_prediction_time > conf.max_prediction_time) {
+            break;
+          }
+          max_viable = nb_samples;
+        }
+      }
+    }
+  }
+
+  // Fitted laws, 'all' pools the observations of all the families
+  std::ofstream fits_out("benchmark_scaling_fits.csv");
+  fits_out << "method,family,metric," << ScalingLaw::csvHeader() << std::endl;
+  // method -> family -> metric -> law
+  std::map<std::string, std::map<std::string, std::map<std::string, ScalingLaw>>> laws;
+  for (auto & method_entry : observations) {
+    MetricsObservations pooled;
+    for (auto & family_entry : method_entry.second) {
+      for (auto & metric_entry : family_entry.second) {
+        std::vector<ScalingObservation> & pooled_metric = pooled[metric_entry.first];
+        pooled_metric.insert(pooled_metric.end(),
+                             metric_entry.second.begin(), metric_entry.second.end());
+      }
+    }
+    method_entry.second["all"] = pooled;
+    for (const auto & family_entry : method_entry.second) {
+      for (const auto & metric_entry : family_entry.second) {
+        ScalingLaw law = fitScalingLaw(metric_entry.second);
+        laws[method_entry.first][family_entry.first][metric_entry.first] = law;
+        fits_out << method_entry.first << ","
+                 << family_entry.first << ","
+                 << metric_entry.first << ",";
+        law.writeCsv(fits_out);
+        fits_out << std::endl;
+      }
+    }
+  }
+
+  // Where do the methods stop being viable? Observed on the ladder and
+  // predicted by the fitted laws
+  std::ofstream viability_out("benchmark_scaling_viability.csv");
+  viability_out << "method,family,nb_dimensions,observed_max_samples,"
+                << "predicted_max_samples,limiting_budget" << std::endl;
+  std::cout << std::endl << "Maximal number of samples within budgets "
+            << "(observed / predicted, limiting budget):" << std::endl;
+  for (const auto & method_entry : viable_samples) {
+    for (const auto & family_entry : method_entry.second) {
+      std::map<std::string, ScalingLaw> & family_laws =
+        laws[method_entry.first][family_entry.first];
+      std::map<std::string, double> budgets;
+      budgets["learning_time"] = conf.max_learning_time;
+      budgets["prediction_time"] = conf.max_prediction_time;
+      for (const auto & dim_entry : family_entry.second) {
+        double predicted = std::numeric_limits<double>::infinity();
+        std::string limiting_budget = "none";
+        for (const auto & budget : budgets) {
+          double max_samples = family_laws[budget.first].maxSamples(budget.second,
+                                                                    dim_entry.first);
+          if (max_samples < predicted) {
+            predicted = max_samples;
+            limiting_budget = budget.first;
+          }
+        }
+        viability_out << method_entry.first << ","
+                      << family_entry.first << ","
+                      << dim_entry.first << ","
+                      << dim_entry.second << ","
+                      << predicted << ","
+                      << limiting_budget << std::endl;
+        std::cout << "\t" << method_entry.first << ", " << family_entry.first
+                  << ", d=" << dim_entry.first << ": "
+                  << dim_entry.second << " / " << std::floor(predicted)
+                  << " (" << limiting_budget << ")" << std::endl;
+      }
+    }
+  }
+}
@@ -0,0 +1,172 @@
+#include "regression_experiments/sequential_design.h"
+#include "regression_experiments/tools.h"
+#include "regression_experiments/trace_recorder.h"
+
+#include <atomic>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <thread>
+
+using namespace regression_experiments;
+
+using rosban_fa::Trainer;
+
+class SequentialConfig : public rosban_utils::Serializable
+{
+public:
+  /// Which trainers are used? name -> trainer
+  std::map<std::string, std::shared_ptr<const Trainer>> methods;
+  /// Which functions are used? name -> function
+  std::map<std::string, std::shared_ptr<const BenchmarkFunction>> functions;
+  /// Number of uniform samples before the first fit
+  int nb_initial_samples;
+  /// Number of fit / getMaximum / sample iterations of each loop
+  int nb_iterations;
+  /// Number of independent loops for each (function, method)
+  int nb_trials;
+  /// Number of threads allowed for each method
+  int nb_threads;
+  /// Number of loops run simultaneously
+  int nb_workers;
+  /// If not empty, a Chrome trace of the benchmark is written at this path
+  std::string trace_path;
+  /// Seed of the random streams, drawn randomly if not provided
+  uint32_t seed;
+
+  std::string class_name() const override
+    {
+      return "sequential_config";
+    }
+
+  void to_xml(std::ostream &out) const override
+    {
+      (void) out;
+      throw std::logic_error("SequentialConfig::to_xml: Not implemented");
+    }
+
+  void from_xml(TiXmlNode *node)
+    {
+      nb_initial_samples = rosban_utils::xml_tools::read<int>(node, "nb_initial_samples");
+      nb_iterations      = rosban_utils::xml_tools::read<int>(node, "nb_iterations"     );
+      nb_trials          = rosban_utils::xml_tools::read<int>(node, "nb_trials"         );
+      nb_threads         = rosban_utils::xml_tools::read<int>(node, "nb_threads"        );
+      if (nb_iterations < 1) {
+        throw std::runtime_error("SequentialConfig: nb_iterations should be at least 1");
+      }
+      nb_workers = 1;
+      rosban_utils::xml_tools::try_read<int>        (node, "nb_workers", nb_workers);
+      rosban_utils::xml_tools::try_read<std::string>(node, "trace_path", trace_path);
+      int read_seed = -1;
+      rosban_utils::xml_tools::try_read<int>(node, "seed", read_seed);
+      seed = read_seed >= 0 ? (uint32_t)read_seed : std::random_device()();
+      // Read methods and functions
+      methods = readTrainers(node, "methods", nb_threads);
+      functions = readFunctions(node, "functions");
+    }
+};
+
+/// An independent loop
+struct SequentialTask
+{
+  int function_id;
+  std::string function_name;
+  std::shared_ptr<const BenchmarkFunction> function;
+  std::string method_name;
+  std::shared_ptr<const Trainer> trainer;
+  int trial;
+};
+
+int main()
+{
+  SequentialConfig conf;
+  conf.load_file();
+
+  std::cout << "Using seed: " << conf.seed << std::endl;
+  if (conf.trace_path != "") {
+    TraceRecorder::getInstance().enable();
+    TraceRecorder::getInstance().setThreadName("main");
+  }
+
+  std::ofstream out;
+  out.open("benchmark_sequential.csv");
+  out << "function_name,method,trial,iteration,nb_samples,"
+      << "fit_time,max_search_time,evaluation_time,cumulative_time,"
+      << "expected_max,arg_max_loss,simple_regret" << std::endl;
+
+  // All methods start from the same initial samples for a given (function, trial)
+  std::vector<SequentialTask> tasks;
+  int function_id = -1;
+  for (auto & function_entry : conf.functions) {
+    function_id++;
+    for (auto & method_entry : conf.methods) {
+      for (int trial = 1; trial <= conf.nb_trials; trial++) {
+        SequentialTask task;
+        task.function_id = function_id;
+        task.function_name = function_entry.first;
+        task.function = function_entry.second;
+        task.method_name = method_entry.first;
+        task.trainer = method_entry.second;
+        task.trial = trial;
+        tasks.push_back(task);
+      }
+    }
+  }
+
+  std::mutex output_mutex;
+  std::atomic<int> next_task(0);
+  auto worker = [&](int worker_id)
+    {
+      TraceRecorder::getInstance().setThreadName("worker_" + std::to_string(worker_id));
+      while (true) {
+        int task_id = next_task++;
+        if (task_id >= (int)tasks.size()) break;
+        const SequentialTask & task = tasks[task_id];
+        TraceScope loop_trace("loop", "cell",
+                              {{"function", task.function_name},
+                               {"method", task.method_name},
+                               {"trial", std::to_string(task.trial)}});
+        std::vector<SequentialIteration> iterations;
+        iterations = runSequentialDesign(task.function, task.trainer,
+                                         conf.nb_initial_samples, conf.nb_iterations,
+                                         RandomStream(conf.seed, task.function_id, task.trial),
+                                         conf.nb_threads);
+        std::ostringstream lines;
+        for (const SequentialIteration & it : iterations) {
+          lines << task.function_name  << ","
+                << task.method_name    << ","
+                << task.trial          << ","
+                << it.iteration        << ","
+                << it.nb_samples       << ","
+                << it.fit_time         << ","
+                << it.max_search_time  << ","
+                << it.evaluation_time  << ","
+                << it.cumulative_time  << ","
+                << it.expected_max     << ","
+                << it.arg_max_loss     << ","
+                << it.simple_regret    << std::endl;
+        }
+        std::lock_guard<std::mutex> lock(output_mutex);
+        std::cout << "Loop " << (task_id + 1) << "/" << tasks.size() << " ('"
+                  << task.function_name << "' with '" << task.method_name
+                  << "', trial " << task.trial << "): final regret "
+                  << iterations.back().simple_regret << std::endl;
+        out << lines.str();
+      }
+    };
+
+  std::vector<std::thread> workers;
+  for (int worker_id = 0; worker_id < conf.nb_workers; worker_id++) {
+    workers.push_back(std::thread(worker, worker_id));
+  }
+  for (std::thread & thread : workers) {
+    thread.join();
+  }
+
+  if (conf.trace_path != "") {
+    TraceRecorder::getInstance().writeJson(conf.trace_path);
+  }
+}
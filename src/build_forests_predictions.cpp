@@ -6,11 +6,22 @@
 #include "rosban_random/tools.h"
 
 #include <fstream>
+#include <string>
 
 using namespace regression_experiments;
 
-int main()
+/// Usage: build_forests_predictions [nb_trees...]
+/// Default number of trees are 1, 10 and 100, see tune_trainers to choose them
+int main(int argc, char ** argv)
 {
+  std::vector<int> nb_trees_vec = {1, 10, 100};
+  if (argc > 1) {
+    nb_trees_vec.clear();
+    for (int i = 1; i < argc; i++) {
+      nb_trees_vec.push_back(std::stoi(argv[i]));
+    }
+  }
+
   // Random initialization
   auto engine = rosban_random::getRandomEngine();
 
@@ -45,7 +56,7 @@ int main()
   prediction_out  << "nbTrees,input,output" << std::endl;
   
   // Iterate on the number of trees
-  for (int nb_trees : {1, 10,100}) {
+  for (int nb_trees : nb_trees_vec) {
     // Creating trainer
     rosban_fa::PWLForestTrainer trainer;
     trainer.setNbTrees(nb_trees);
@@ -0,0 +1,111 @@
+#include "regression_experiments/adaptive_grid.h"
+#include "regression_experiments/benchmark_function_factory.h"
+#include "regression_experiments/prediction_exporter.h"
+
+#include "rosban_fa/trainer_factory.h"
+
+#include "rosban_random/tools.h"
+
+#include <iostream>
+
+using namespace regression_experiments;
+
+using rosban_fa::Trainer;
+using rosban_fa::TrainerFactory;
+using rosban_fa::FunctionApproximator;
+
+class ExportConfig : public rosban_utils::Serializable
+{
+public:
+  /// The function to approximate
+  std::unique_ptr<BenchmarkFunction> function;
+  /// The trainer used to build the approximation
+  std::unique_ptr<Trainer> trainer;
+  /// Number of samples used for training
+  int nb_samples;
+  /// Number of points along each dimension of the exported grid
+  std::vector<int> points_by_dim;
+  /// Dimensions which are not discretized (slice)
+  std::vector<int> fixed_dims;
+  /// Value used for each of the fixed dimensions
+  std::vector<double> fixed_values;
+  /// If provided, the grid is refined where the prediction changes and
+  /// points_by_dim is ignored
+  std::unique_ptr<RefinementConfig> refinement;
+  /// Number of lines written at once
+  int chunk_size;
+  /// Path of the output file
+  std::string output_path;
+
+  ExportConfig() : nb_samples(100), chunk_size(4096), output_path("predictions.csv") {}
+
+  std::string class_name() const override
+    {
+      return "export_config";
+    }
+
+  void to_xml(std::ostream &out) const override
+    {
+      (void) out;
+      throw std::logic_error("ExportConfig::to_xml: Not implemented");
+    }
+
+  void from_xml(TiXmlNode *node)
+    {
+      function = BenchmarkFunctionFactory().build(node->FirstChild("function"));
+      trainer = TrainerFactory().build(node->FirstChild("trainer"));
+      nb_samples = rosban_utils::xml_tools::read<int>(node, "nb_samples");
+      if (node->FirstChild("refinement") != NULL) {
+        refinement.reset(new RefinementConfig());
+        refinement->read(node, "refinement");
+      }
+      else {
+        points_by_dim = rosban_utils::xml_tools::read_vector<int>(node, "points_by_dim");
+      }
+      rosban_utils::xml_tools::try_read_vector<int>   (node, "fixed_dims"  , fixed_dims  );
+      rosban_utils::xml_tools::try_read_vector<double>(node, "fixed_values", fixed_values);
+      rosban_utils::xml_tools::try_read<int>          (node, "chunk_size"  , chunk_size  );
+      rosban_utils::xml_tools::try_read<std::string>  (node, "output_path" , output_path );
+      if (fixed_dims.size() != fixed_values.size()) {
+        throw std::runtime_error("ExportConfig: fixed_dims and fixed_values sizes differ");
+      }
+    }
+};
+
+int main()
+{
+  ExportConfig conf;
+  conf.load_file();
+
+  auto engine = rosban_random::getRandomEngine();
+
+  // Training
+  Eigen::MatrixXd samples_inputs;
+  Eigen::VectorXd samples_outputs;
+  Eigen::MatrixXd limits = conf.function->getLimits();
+  conf.function->getUniformSamples(conf.nb_samples, samples_inputs, samples_outputs, &engine);
+  std::shared_ptr<const FunctionApproximator> fa;
+  fa = conf.trainer->train(samples_inputs, samples_outputs, limits);
+
+  // Exporting observations and the requested slice of the prediction grid
+  std::map<int, double> fixed_values;
+  for (size_t i = 0; i < conf.fixed_dims.size(); i++) {
+    fixed_values[conf.fixed_dims[i]] = conf.fixed_values[i];
+  }
+  PredictionExporter exporter(conf.output_path, limits.rows(), conf.chunk_size);
+  exporter.writeObservations(samples_inputs, samples_outputs);
+  if (conf.refinement) {
+    AdaptivePrediction prediction;
+    prediction = buildAdaptivePrediction(fa, limits, *conf.refinement, fixed_values);
+    exporter.writePredictions(prediction.points, prediction.means,
+                              prediction.vars, prediction.gradients);
+    std::cout << "Exported " << prediction.points.cols() << " predictions to '"
+              << conf.output_path << "' (dense grid with the same resolution: "
+              << prediction.dense_grid_size << " points)" << std::endl;
+  }
+  else {
+    long nb_points = exporter.exportGrid(fa, limits, conf.points_by_dim, fixed_values);
+    std::cout << "Exported " << nb_points << " predictions to '"
+              << conf.output_path << "'" << std::endl;
+  }
+}
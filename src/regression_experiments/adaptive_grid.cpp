@@ -0,0 +1,269 @@
+#include "regression_experiments/adaptive_grid.h"
+
+#include "regression_experiments/parallel.h"
+#include "regression_experiments/trace_recorder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+
+using rosban_fa::FunctionApproximator;
+
+namespace regression_experiments
+{
+
+RefinementConfig::RefinementConfig()
+  : max_depth(4), mean_tolerance(-1), var_tolerance(-1), gradient_tolerance(-1),
+    max_points(1000000), batch_size(1024), nb_threads(1)
+{
+}
+
+std::string RefinementConfig::class_name() const
+{
+  return "refinement";
+}
+
+void RefinementConfig::to_xml(std::ostream &out) const
+{
+  rosban_utils::xml_tools::write_vector<int>("initial_points_by_dim", initial_points_by_dim, out);
+  rosban_utils::xml_tools::write<int>   ("max_depth"         , max_depth         , out);
+  rosban_utils::xml_tools::write<double>("mean_tolerance"    , mean_tolerance    , out);
+  rosban_utils::xml_tools::write<double>("var_tolerance"     , var_tolerance     , out);
+  rosban_utils::xml_tools::write<double>("gradient_tolerance", gradient_tolerance, out);
+  rosban_utils::xml_tools::write<long>  ("max_points"        , max_points        , out);
+  rosban_utils::xml_tools::write<int>   ("batch_size"        , batch_size        , out);
+  rosban_utils::xml_tools::write<int>   ("nb_threads"        , nb_threads        , out);
+}
+
+void RefinementConfig::from_xml(TiXmlNode *node)
+{
+  initial_points_by_dim = rosban_utils::xml_tools::read_vector<int>(node, "initial_points_by_dim");
+  rosban_utils::xml_tools::try_read<int>   (node, "max_depth"         , max_depth         );
+  rosban_utils::xml_tools::try_read<double>(node, "mean_tolerance"    , mean_tolerance    );
+  rosban_utils::xml_tools::try_read<double>(node, "var_tolerance"     , var_tolerance     );
+  rosban_utils::xml_tools::try_read<double>(node, "gradient_tolerance", gradient_tolerance);
+  rosban_utils::xml_tools::try_read<long>  (node, "max_points"        , max_points        );
+  rosban_utils::xml_tools::try_read<int>   (node, "batch_size"        , batch_size        );
+  rosban_utils::xml_tools::try_read<int>   (node, "nb_threads"        , nb_threads        );
+  if (mean_tolerance < 0 && var_tolerance < 0 && gradient_tolerance < 0) {
+    throw std::runtime_error("RefinementConfig: at least one tolerance should be provided");
+  }
+}
+
+/// A hyperrectangle of the lattice, identified by its lowest vertex
+struct GridCell
+{
+  std::vector<long> corner;
+  int depth;
+};
+
+AdaptivePrediction buildAdaptivePrediction(std::shared_ptr<const FunctionApproximator> fa,
+                                           const Eigen::MatrixXd & limits,
+                                           const RefinementConfig & config,
+                                           const std::map<int, double> & fixed_values)
+{
+  int input_dim = limits.rows();
+  // Checking consistency
+  if ((int)config.initial_points_by_dim.size() != input_dim) {
+    throw std::logic_error("buildAdaptivePrediction: inconsistent dimensions");
+  }
+  if (config.max_depth < 0 || config.max_depth > 20 || config.batch_size <= 0) {
+    throw std::logic_error("buildAdaptivePrediction: invalid max_depth or batch_size");
+  }
+  for (const auto & entry : fixed_values) {
+    if (entry.first < 0 || entry.first >= input_dim) {
+      throw std::logic_error("buildAdaptivePrediction: invalid fixed dimension");
+    }
+  }
+  // Fixed values and default values are shared by all points
+  Eigen::VectorXd default_input(input_dim);
+  for (int dim = 0; dim < input_dim; dim++) {
+    auto it = fixed_values.find(dim);
+    if (it != fixed_values.end()) {
+      default_input(dim) = it->second;
+    }
+    else {
+      default_input(dim) = (limits(dim, 0) + limits(dim, 1)) / 2;
+    }
+  }
+  // Refined dimensions are placed on a lattice whose resolution is the one
+  // reached at max_depth, the coordinates of a point are its key
+  long finest_step = 1l << config.max_depth;
+  std::vector<int> refined_dims;
+  std::vector<long> lattice_size;
+  double dense_grid_size = 1;
+  for (int dim = 0; dim < input_dim; dim++) {
+    int nb_points = config.initial_points_by_dim[dim];
+    if (fixed_values.count(dim) > 0 || nb_points < 2) continue;
+    refined_dims.push_back(dim);
+    lattice_size.push_back((nb_points - 1) * finest_step + 1);
+    dense_grid_size *= lattice_size.back();
+  }
+  if (dense_grid_size > 1e18) {
+    throw std::logic_error("buildAdaptivePrediction: lattice is too large, reduce max_depth");
+  }
+  int nb_refined = refined_dims.size();
+  int nb_vertices = 1 << nb_refined;
+
+  // The initial grid is always predicted
+  double initial_grid_size = 1;
+  for (int dim : refined_dims) initial_grid_size *= config.initial_points_by_dim[dim];
+  if (initial_grid_size > config.max_points) {
+    throw std::logic_error("buildAdaptivePrediction: initial grid is larger than max_points");
+  }
+  // Key of a vertex of the cell with the given corner and size
+  auto vertex_key = [&](const std::vector<long> & corner, long cell_size, int vertex) -> uint64_t
+    {
+      uint64_t key = 0;
+      for (int i = 0; i < nb_refined; i++) {
+        long coordinate = corner[i] + ((vertex & (1 << i)) ? cell_size : 0);
+        key = key * lattice_size[i] + coordinate;
+      }
+      return key;
+    };
+
+  AdaptivePrediction result;
+  result.dense_grid_size = dense_grid_size;
+  std::unordered_map<uint64_t, int> point_ids;
+  long nb_points = 0;
+  // Initial cells
+  std::vector<GridCell> cells(1);
+  cells[0].corner.assign(nb_refined, 0);
+  cells[0].depth = 0;
+  for (int i = 0; i < nb_refined; i++) {
+    std::vector<GridCell> next_cells;
+    for (const GridCell & cell : cells) {
+      for (int index = 0; index < config.initial_points_by_dim[refined_dims[i]] - 1; index++) {
+        GridCell next_cell = cell;
+        next_cell.corner[i] = index * finest_step;
+        next_cells.push_back(next_cell);
+      }
+    }
+    cells = next_cells;
+  }
+  // Cells of the same depth are handled together: new vertices are predicted
+  // in batches and cells with a large variation are split
+  while (!cells.empty()) {
+    TraceScope trace("refine", "prediction",
+                     {{"depth", std::to_string(cells[0].depth)},
+                      {"nb_cells", std::to_string(cells.size())}});
+    // Identifying vertices of the cells
+    std::vector<std::vector<int>> cells_vertices(cells.size());
+    std::vector<std::vector<long>> new_points;
+    for (size_t cell_id = 0; cell_id < cells.size(); cell_id++) {
+      const GridCell & cell = cells[cell_id];
+      long cell_size = finest_step >> cell.depth;
+      for (int vertex = 0; vertex < nb_vertices; vertex++) {
+        uint64_t key = vertex_key(cell.corner, cell_size, vertex);
+        auto it = point_ids.find(key);
+        if (it == point_ids.end()) {
+          std::vector<long> coordinates(cell.corner);
+          for (int i = 0; i < nb_refined; i++) {
+            if (vertex & (1 << i)) coordinates[i] += cell_size;
+          }
+          it = point_ids.insert(std::make_pair(key, (int)(nb_points + new_points.size()))).first;
+          new_points.push_back(coordinates);
+        }
+        cells_vertices[cell_id].push_back(it->second);
+      }
+    }
+    // Predicting new vertices
+    long first_point = nb_points;
+    nb_points += new_points.size();
+    result.points.conservativeResize(input_dim, nb_points);
+    result.means.conservativeResize(nb_points);
+    result.vars.conservativeResize(nb_points);
+    result.gradients.conservativeResize(input_dim, nb_points);
+    for (size_t i = 0; i < new_points.size(); i++) {
+      Eigen::VectorXd input = default_input;
+      for (int j = 0; j < nb_refined; j++) {
+        int dim = refined_dims[j];
+        double ratio = new_points[i][j] / (double)(lattice_size[j] - 1);
+        input(dim) = limits(dim, 0) + ratio * (limits(dim, 1) - limits(dim, 0));
+      }
+      result.points.col(first_point + i) = input;
+    }
+    int nb_batches = (new_points.size() + config.batch_size - 1) / config.batch_size;
+    runParallel(nb_batches, config.nb_threads, [&](int start, int end)
+                {
+                  Eigen::VectorXd gradient;
+                  long batch_start = first_point + (long)start * config.batch_size;
+                  long batch_end = std::min(nb_points, first_point + (long)end * config.batch_size);
+                  for (long point = batch_start; point < batch_end; point++) {
+                    fa->predict(result.points.col(point), result.means(point), result.vars(point));
+                    fa->gradient(result.points.col(point), gradient);
+                    result.gradients.col(point) = gradient;
+                  }
+                });
+    // Cells exceeding a tolerance, with their largest variation relative to
+    // the tolerances
+    std::vector<std::pair<double, size_t>> candidates;
+    for (size_t cell_id = 0; cell_id < cells.size(); cell_id++) {
+      const GridCell & cell = cells[cell_id];
+      if (cell.depth >= config.max_depth) continue;
+      const std::vector<int> & vertices = cells_vertices[cell_id];
+      int first = vertices[0];
+      double min_mean = result.means(first), max_mean = result.means(first);
+      double min_var = result.vars(first), max_var = result.vars(first);
+      double gradient_diff = 0;
+      for (int vertex : vertices) {
+        min_mean = std::min(min_mean, result.means(vertex));
+        max_mean = std::max(max_mean, result.means(vertex));
+        min_var = std::min(min_var, result.vars(vertex));
+        max_var = std::max(max_var, result.vars(vertex));
+        double diff = (result.gradients.col(vertex) - result.gradients.col(first)).norm();
+        gradient_diff = std::max(gradient_diff, diff);
+      }
+      std::vector<std::pair<double, double>> variations = {
+        {max_mean - min_mean, config.mean_tolerance},
+        {max_var - min_var, config.var_tolerance},
+        {gradient_diff, config.gradient_tolerance}
+      };
+      double ratio = 0;
+      for (const auto & variation : variations) {
+        double tolerance = variation.second;
+        if (tolerance < 0 || variation.first <= tolerance) continue;
+        ratio = std::max(ratio, tolerance > 0 ? variation.first / tolerance
+                                              : std::numeric_limits<double>::infinity());
+      }
+      if (ratio > 0) candidates.push_back(std::make_pair(ratio, cell_id));
+    }
+    // Cells with the largest variations are split first, as long as the new
+    // vertices of their children fit in the remaining budget
+    std::stable_sort(candidates.begin(), candidates.end(),
+                     [](const std::pair<double, size_t> & a, const std::pair<double, size_t> & b)
+                     {
+                       return a.first > b.first;
+                     });
+    std::unordered_set<uint64_t> planned_keys;
+    std::vector<GridCell> next_cells;
+    for (const auto & candidate : candidates) {
+      const GridCell & cell = cells[candidate.second];
+      long child_size = finest_step >> (cell.depth + 1);
+      std::vector<GridCell> children;
+      std::unordered_set<uint64_t> new_keys;
+      for (int child = 0; child < nb_vertices; child++) {
+        GridCell child_cell = cell;
+        child_cell.depth++;
+        for (int i = 0; i < nb_refined; i++) {
+          if (child & (1 << i)) child_cell.corner[i] += child_size;
+        }
+        for (int vertex = 0; vertex < nb_vertices; vertex++) {
+          uint64_t key = vertex_key(child_cell.corner, child_size, vertex);
+          if (point_ids.count(key) == 0 && planned_keys.count(key) == 0) new_keys.insert(key);
+        }
+        children.push_back(child_cell);
+      }
+      if (nb_points + (long)(planned_keys.size() + new_keys.size()) > config.max_points) continue;
+      planned_keys.insert(new_keys.begin(), new_keys.end());
+      next_cells.insert(next_cells.end(), children.begin(), children.end());
+    }
+    cells = next_cells;
+  }
+  return result;
+}
+
+}
@@ -0,0 +1,117 @@
+#include "regression_experiments/anytime_profile.h"
+
+#include "rosban_utils/time_stamp.h"
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+
+using rosban_utils::TimeStamp;
+using rosban_fa::FunctionApproximator;
+
+namespace regression_experiments
+{
+
+std::vector<AnytimePoint> runAnytimeProfile(std::shared_ptr<const BenchmarkFunction> function,
+                                            std::shared_ptr<const FunctionApproximator> fa,
+                                            std::vector<int> evaluation_budgets,
+                                            std::vector<double> time_budgets,
+                                            const RandomStream & stream,
+                                            int batch_size)
+{
+  if (batch_size <= 0) {
+    throw std::logic_error("runAnytimeProfile: batch_size should be strictly positive");
+  }
+  std::sort(evaluation_budgets.begin(), evaluation_budgets.end());
+  std::sort(time_budgets.begin(), time_budgets.end());
+  Eigen::MatrixXd limits = function->getLimits();
+  // Checkpoints and the candidate associated to each of them
+  std::vector<AnytimePoint> points;
+  std::vector<Eigen::VectorXd> candidates;
+  // Random search
+  Eigen::VectorXd best_input;
+  double best_value = std::numeric_limits<double>::lowest();
+  size_t next_evaluation_budget = 0;
+  size_t next_time_budget = 0;
+  int nb_evaluations = 0;
+  TimeStamp start = TimeStamp::now();
+  for (uint32_t batch = 0; ; batch++) {
+    // Stop once all budgets have been reached
+    if (next_evaluation_budget >= evaluation_budgets.size() &&
+        next_time_budget >= time_budgets.size()) {
+      break;
+    }
+    Eigen::MatrixXd batch_inputs =
+      stream.withSubstream(batch).uniformSamples(limits, batch_size);
+    for (int i = 0; i < batch_size; i++) {
+      double mean, var;
+      fa->predict(batch_inputs.col(i), mean, var);
+      nb_evaluations++;
+      if (mean > best_value) {
+        best_value = mean;
+        best_input = batch_inputs.col(i);
+      }
+      while (next_evaluation_budget < evaluation_budgets.size() &&
+             nb_evaluations >= evaluation_budgets[next_evaluation_budget]) {
+        AnytimePoint point;
+        point.budget_type = "evaluations";
+        point.budget = evaluation_budgets[next_evaluation_budget];
+        point.nb_evaluations = nb_evaluations;
+        point.elapsed_time = diffSec(start, TimeStamp::now());
+        point.expected_max = best_value;
+        points.push_back(point);
+        candidates.push_back(best_input);
+        next_evaluation_budget++;
+      }
+    }
+    // Time budgets are checked once per batch
+    double elapsed = diffSec(start, TimeStamp::now());
+    while (next_time_budget < time_budgets.size() &&
+           elapsed >= time_budgets[next_time_budget]) {
+      AnytimePoint point;
+      point.budget_type = "time";
+      point.budget = time_budgets[next_time_budget];
+      point.nb_evaluations = nb_evaluations;
+      point.elapsed_time = elapsed;
+      point.expected_max = best_value;
+      points.push_back(point);
+      candidates.push_back(best_input);
+      next_time_budget++;
+    }
+  }
+  // Reference: native maximum search of the approximator
+  {
+    AnytimePoint point;
+    Eigen::VectorXd native_input;
+    TimeStamp native_start = TimeStamp::now();
+    fa->getMaximum(limits, native_input, point.expected_max);
+    point.elapsed_time = diffSec(native_start, TimeStamp::now());
+    point.budget_type = "native";
+    point.budget = 0;
+    point.nb_evaluations = -1;
+    points.push_back(point);
+    candidates.push_back(native_input);
+  }
+  // Evaluating all candidates at once
+  Eigen::MatrixXd candidates_matrix(limits.rows(), candidates.size());
+  for (size_t i = 0; i < candidates.size(); i++) {
+    candidates_matrix.col(i) = candidates[i];
+  }
+  Eigen::VectorXd values = function->sampleBatch(candidates_matrix, 1);
+  try{
+    double max = function->getMax();
+    for (size_t i = 0; i < points.size(); i++) {
+      points[i].arg_max_loss = max - values(i);
+    }
+  }
+  catch(const std::runtime_error & exc) {
+    for (AnytimePoint & point : points) {
+      point.arg_max_loss = -1;
+    }
+    std::cerr << exc.what() << std::endl;
+  }
+  return points;
+}
+
+}
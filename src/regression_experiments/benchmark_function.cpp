@@ -1,10 +1,14 @@
 #include "regression_experiments/benchmark_function.h"
 
+#include "regression_experiments/parallel.h"
+
 #include "rosban_gp/tools.h"
 
 #include "rosban_random/tools.h"
 
+#include <algorithm>
 #include <functional>
+#include <vector>
 
 namespace regression_experiments
 {
@@ -18,6 +22,24 @@ double BenchmarkFunction::getMax() const
   throw std::runtime_error("Unimplemented getMax for given function");
 }
 
+double BenchmarkFunction::getObservationNoise() const
+{
+  return observation_noise;
+}
+
+Eigen::VectorXd BenchmarkFunction::sampleBatch(const Eigen::MatrixXd & inputs,
+                                               int nb_threads) const
+{
+  Eigen::VectorXd values(inputs.cols());
+  runParallel(inputs.cols(), nb_threads, [this, &inputs, &values](int start, int end)
+              {
+                for (int i = start; i < end; i++) {
+                  values(i) = this->sample(inputs.col(i));
+                }
+              });
+  return values;
+}
+
 void BenchmarkFunction::getUniformSamples(int nb_samples,
                                           Eigen::MatrixXd & samples,
                                           Eigen::VectorXd & observations,
@@ -45,6 +67,60 @@ void BenchmarkFunction::getUniformSamples(int nb_samples,
   if (cleanup) delete(engine);
 }
 
+void BenchmarkFunction::getUniformSamples(int nb_samples,
+                                          Eigen::MatrixXd & samples,
+                                          Eigen::VectorXd & observations,
+                                          const RandomStream & stream,
+                                          bool apply_noise,
+                                          int nb_threads) const
+{
+  getSamples(nb_samples, samples, observations, UniformDesign(), stream, apply_noise, nb_threads);
+}
+
+void BenchmarkFunction::getUniformSamples(int nb_samples,
+                                          Eigen::MatrixXf & samples,
+                                          Eigen::VectorXf & observations,
+                                          const RandomStream & stream,
+                                          bool apply_noise,
+                                          int nb_threads,
+                                          int chunk_size) const
+{
+  Eigen::MatrixXd limits = getLimits();
+  samples.resize(limits.rows(), nb_samples);
+  observations.resize(nb_samples);
+  RandomStream inputs_stream = stream.withSubstream(0);
+  RandomStream noise_stream = stream.withSubstream(1);
+  std::vector<double> noise(chunk_size);
+  for (int start = 0; start < nb_samples; start += chunk_size) {
+    int size = std::min(chunk_size, nb_samples - start);
+    Eigen::MatrixXd chunk_samples = inputs_stream.uniformSamples(limits, start, size, nb_threads);
+    Eigen::VectorXd chunk_observations = sampleBatch(chunk_samples, nb_threads);
+    if (apply_noise && observation_noise > 0) {
+      noise_stream.gaussian(start, size, noise.data());
+      for (int i = 0; i < size; i++) {
+        chunk_observations(i) += observation_noise * noise[i];
+      }
+    }
+    samples.middleCols(start, size) = chunk_samples.cast<float>();
+    observations.segment(start, size) = chunk_observations.cast<float>();
+  }
+}
+
+void BenchmarkFunction::getSamples(int nb_samples,
+                                   Eigen::MatrixXd & samples,
+                                   Eigen::VectorXd & observations,
+                                   const SamplingDesign & design,
+                                   const RandomStream & stream,
+                                   bool apply_noise,
+                                   int nb_threads) const
+{
+  samples = design.getSamples(getLimits(), nb_samples, stream.withSubstream(0), nb_threads);
+  observations = sampleBatch(samples, nb_threads);
+  if (apply_noise && observation_noise > 0) {
+    observations += observation_noise * stream.withSubstream(1).gaussian(nb_samples, nb_threads);
+  }
+}
+
 void BenchmarkFunction::to_xml(std::ostream &out) const
 {
   rosban_utils::xml_tools::write<double>("observation_noise", observation_noise, out);
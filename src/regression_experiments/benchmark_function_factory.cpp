@@ -1,5 +1,7 @@
 #include "regression_experiments/benchmark_function_factory.h"
 #include "regression_experiments/basic_functions.h"
+#include "regression_experiments/expensive_function.h"
+#include "regression_experiments/random_function.h"
 
 namespace regression_experiments
 {
@@ -10,6 +12,10 @@ BenchmarkFunctionFactory::BenchmarkFunctionFactory()
   registerBuilder("abs_diff" , [](){return std::unique_ptr<BenchmarkFunction>(new AbsDiff); });
   registerBuilder("discontinuity",
                   [](){return std::unique_ptr<BenchmarkFunction>(new Discontinuity);});
+  registerBuilder("expensive",
+                  [](){return std::unique_ptr<BenchmarkFunction>(new ExpensiveFunction);});
+  registerBuilder("random_function",
+                  [](){return std::unique_ptr<BenchmarkFunction>(new RandomFunction);});
 }
 
 }
@@ -0,0 +1,181 @@
+#include "regression_experiments/counter_rng.h"
+
+#include "regression_experiments/parallel.h"
+
+#include <cmath>
+
+namespace regression_experiments
+{
+
+/// Constants from Salmon et al. 2011
+static const uint32_t philox_m0 = 0xD2511F53;
+static const uint32_t philox_m1 = 0xCD9E8D57;
+static const uint32_t philox_w0 = 0x9E3779B9;
+static const uint32_t philox_w1 = 0xBB67AE85;
+static const int philox_rounds = 10;
+
+/// Number of blocks generated at once before conversion
+static const size_t blocks_per_batch = 256;
+
+Philox4x32::Counter Philox4x32::generate(const Counter & counter, const Key & key)
+{
+  uint32_t c0 = counter[0], c1 = counter[1], c2 = counter[2], c3 = counter[3];
+  uint32_t k0 = key[0], k1 = key[1];
+  for (int round = 0; round < philox_rounds; round++) {
+    uint64_t p0 = (uint64_t)philox_m0 * c0;
+    uint64_t p1 = (uint64_t)philox_m1 * c2;
+    uint32_t hi0 = (uint32_t)(p0 >> 32), lo0 = (uint32_t)p0;
+    uint32_t hi1 = (uint32_t)(p1 >> 32), lo1 = (uint32_t)p1;
+    c0 = hi1 ^ c1 ^ k0;
+    c1 = lo1;
+    c2 = hi0 ^ c3 ^ k1;
+    c3 = lo0;
+    k0 += philox_w0;
+    k1 += philox_w1;
+  }
+  return {{c0, c1, c2, c3}};
+}
+
+/// Convert two words to a double in ]0,1] with 53 bits of precision
+static inline double toUniform(uint32_t high, uint32_t low)
+{
+  uint64_t bits = ((uint64_t)(high >> 5) << 26) | (low >> 6);
+  return (bits + 1) * (1.0 / 9007199254740992.0);
+}
+
+RandomStream::RandomStream(uint32_t seed_, uint32_t cell_, uint32_t trial_,
+                           uint32_t purpose_, uint32_t substream_)
+  : seed(seed_), cell(cell_), trial(trial_), purpose(purpose_), substream(substream_)
+{}
+
+RandomStream RandomStream::withPurpose(uint32_t new_purpose) const
+{
+  return RandomStream(seed, cell, trial, new_purpose, substream);
+}
+
+RandomStream RandomStream::withSubstream(uint32_t new_substream) const
+{
+  return RandomStream(seed, cell, trial, purpose, new_substream);
+}
+
+void RandomStream::generateBlocks(uint64_t first_block, size_t nb_blocks, uint32_t * dst) const
+{
+  if (first_block + nb_blocks > ((uint64_t)1 << 32)) {
+    throw std::out_of_range("RandomStream: stream exhausted");
+  }
+  Philox4x32::Key key = {{seed, purpose}};
+  // No dependency between iterations: blocks can be computed in any order
+  for (size_t i = 0; i < nb_blocks; i++) {
+    Philox4x32::Counter counter = {{(uint32_t)(first_block + i), substream, cell, trial}};
+    Philox4x32::Counter block = Philox4x32::generate(counter, key);
+    dst[4 * i + 0] = block[0];
+    dst[4 * i + 1] = block[1];
+    dst[4 * i + 2] = block[2];
+    dst[4 * i + 3] = block[3];
+  }
+}
+
+void RandomStream::bits(uint64_t offset, size_t n, uint32_t * dst) const
+{
+  uint32_t words[4 * blocks_per_batch];
+  size_t written = 0;
+  while (written < n) {
+    uint64_t element = offset + written;
+    uint64_t first_block = element / 4;
+    size_t skip = element % 4;
+    size_t nb_blocks = std::min(blocks_per_batch, (n - written + skip + 3) / 4);
+    generateBlocks(first_block, nb_blocks, words);
+    for (size_t word = skip; word < 4 * nb_blocks && written < n; word++) {
+      dst[written++] = words[word];
+    }
+  }
+}
+
+void RandomStream::uniform(uint64_t offset, size_t n, double * dst) const
+{
+  uint32_t words[4 * blocks_per_batch];
+  size_t written = 0;
+  while (written < n) {
+    uint64_t element = offset + written;
+    uint64_t first_block = element / 2;
+    size_t skip = element % 2;
+    size_t nb_blocks = std::min(blocks_per_batch, (n - written + skip + 1) / 2);
+    generateBlocks(first_block, nb_blocks, words);
+    for (size_t value = skip; value < 2 * nb_blocks && written < n; value++) {
+      dst[written++] = toUniform(words[2 * value], words[2 * value + 1]);
+    }
+  }
+}
+
+void RandomStream::gaussian(uint64_t offset, size_t n, double * dst) const
+{
+  uint32_t words[4 * blocks_per_batch];
+  size_t written = 0;
+  while (written < n) {
+    uint64_t element = offset + written;
+    uint64_t first_block = element / 2;
+    size_t skip = element % 2;
+    size_t nb_blocks = std::min(blocks_per_batch, (n - written + skip + 1) / 2);
+    generateBlocks(first_block, nb_blocks, words);
+    // Box-Muller: each block provides two normal values
+    for (size_t block = 0; block < nb_blocks; block++) {
+      double u1 = toUniform(words[4 * block + 0], words[4 * block + 1]);
+      double u2 = toUniform(words[4 * block + 2], words[4 * block + 3]);
+      double radius = std::sqrt(-2 * std::log(u1));
+      double angle = 2 * M_PI * u2;
+      if (skip == 0 && written < n) dst[written++] = radius * std::cos(angle);
+      if (written < n) dst[written++] = radius * std::sin(angle);
+      skip = 0;
+    }
+  }
+}
+
+Eigen::VectorXd RandomStream::uniform(int n, int nb_threads) const
+{
+  Eigen::VectorXd result(n);
+  runParallel(n, nb_threads, [this, &result](int start, int end)
+              { this->uniform(start, end - start, result.data() + start); });
+  return result;
+}
+
+Eigen::VectorXd RandomStream::gaussian(int n, int nb_threads) const
+{
+  Eigen::VectorXd result(n);
+  runParallel(n, nb_threads, [this, &result](int start, int end)
+              { this->gaussian(start, end - start, result.data() + start); });
+  return result;
+}
+
+Eigen::MatrixXd RandomStream::uniformSamples(const Eigen::MatrixXd & limits, int nb_samples,
+                                             int nb_threads) const
+{
+  return uniformSamples(limits, 0, nb_samples, nb_threads);
+}
+
+Eigen::MatrixXd RandomStream::uniformSamples(const Eigen::MatrixXd & limits, int first_sample,
+                                             int nb_samples, int nb_threads) const
+{
+  int dims = limits.rows();
+  Eigen::MatrixXd samples(dims, nb_samples);
+  Eigen::VectorXd low = limits.col(0);
+  Eigen::VectorXd delta = limits.col(1) - limits.col(0);
+  runParallel(nb_samples, nb_threads, [&](int start, int end)
+              {
+                // Column major storage: samples [start, end[ are contiguous
+                double * data = samples.data() + (size_t)start * dims;
+                uint64_t offset = ((uint64_t)first_sample + start) * dims;
+                this->uniform(offset, (size_t)(end - start) * dims, data);
+                for (int sample = start; sample < end; sample++) {
+                  samples.col(sample) = low + delta.cwiseProduct(samples.col(sample));
+                }
+              });
+  return samples;
+}
+
+uint32_t RandomStream::getSeed() const { return seed; }
+uint32_t RandomStream::getCell() const { return cell; }
+uint32_t RandomStream::getTrial() const { return trial; }
+uint32_t RandomStream::getPurpose() const { return purpose; }
+uint32_t RandomStream::getSubstream() const { return substream; }
+
+}
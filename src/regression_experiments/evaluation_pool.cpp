@@ -0,0 +1,156 @@
+#include "regression_experiments/evaluation_pool.h"
+
+#include <chrono>
+#include <stdexcept>
+
+namespace regression_experiments
+{
+
+struct EvaluationPool::Batch
+{
+  Eigen::MatrixXd inputs;
+  Eigen::VectorXd values;
+  /// First input not yet assigned to a worker (protected by the pool mutex)
+  int next_input;
+  /// Number of inputs not evaluated yet (protected by the batch mutex)
+  int remaining;
+  /// Sum of the durations of the evaluations in nanoseconds (protected by the
+  /// batch mutex)
+  long long evaluation_time;
+  std::exception_ptr exception;
+  std::promise<Eigen::VectorXd> promise;
+  std::future<Eigen::VectorXd> future;
+  std::mutex mutex;
+};
+
+EvaluationPool::EvaluationPool(Evaluator evaluator_, int nb_workers, int chunk_size_)
+  : evaluator(evaluator_), chunk_size(chunk_size_), stopping(false),
+    nb_evaluations(0), evaluation_time(0)
+{
+  if (nb_workers < 1 || chunk_size < 1) {
+    throw std::logic_error("EvaluationPool: nb_workers and chunk_size should be at least 1");
+  }
+  for (int worker = 0; worker < nb_workers; worker++) {
+    workers.push_back(std::thread(&EvaluationPool::work, this));
+  }
+}
+
+EvaluationPool::~EvaluationPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  condition.notify_all();
+  for (std::thread & worker : workers) {
+    worker.join();
+  }
+}
+
+std::shared_ptr<EvaluationPool::Batch> EvaluationPool::enqueue(const Eigen::MatrixXd & inputs)
+{
+  std::shared_ptr<Batch> batch(new Batch);
+  batch->inputs = inputs;
+  batch->values = Eigen::VectorXd::Zero(inputs.cols());
+  batch->next_input = 0;
+  batch->remaining = inputs.cols();
+  batch->evaluation_time = 0;
+  batch->future = batch->promise.get_future();
+  if (inputs.cols() == 0) {
+    batch->promise.set_value(batch->values);
+    return batch;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    queue.push_back(batch);
+  }
+  condition.notify_all();
+  return batch;
+}
+
+std::future<Eigen::VectorXd> EvaluationPool::submit(const Eigen::MatrixXd & inputs)
+{
+  return std::move(enqueue(inputs)->future);
+}
+
+Eigen::VectorXd EvaluationPool::evaluate(const Eigen::MatrixXd & inputs, double * batch_time)
+{
+  std::shared_ptr<Batch> batch = enqueue(inputs);
+  // Durations are added before the promise is fulfilled
+  Eigen::VectorXd values = batch->future.get();
+  if (batch_time != nullptr) {
+    std::lock_guard<std::mutex> lock(batch->mutex);
+    *batch_time = batch->evaluation_time / 1e9;
+  }
+  return values;
+}
+
+int EvaluationPool::getNbWorkers() const
+{
+  return workers.size();
+}
+
+long EvaluationPool::getNbEvaluations() const
+{
+  return nb_evaluations;
+}
+
+double EvaluationPool::getEvaluationTime() const
+{
+  return evaluation_time / 1e9;
+}
+
+void EvaluationPool::work()
+{
+  while (true) {
+    std::shared_ptr<Batch> batch;
+    int start, end;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      condition.wait(lock, [this]() { return stopping || !queue.empty(); });
+      if (queue.empty()) return;
+      // Claiming a chunk of the oldest batch
+      batch = queue.front();
+      start = batch->next_input;
+      end = std::min(start + chunk_size, (int)batch->inputs.cols());
+      batch->next_input = end;
+      if (end == batch->inputs.cols()) {
+        queue.pop_front();
+      }
+    }
+    std::exception_ptr exception;
+    long long chunk_time = 0;
+    for (int input = start; input < end && !exception; input++) {
+      auto call_start = std::chrono::steady_clock::now();
+      try {
+        batch->values(input) = evaluator(batch->inputs.col(input));
+      }
+      catch (...) {
+        exception = std::current_exception();
+      }
+      auto duration = std::chrono::steady_clock::now() - call_start;
+      chunk_time += std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+      nb_evaluations++;
+    }
+    evaluation_time += chunk_time;
+    // The last worker to finish a batch fulfills the promise
+    bool done;
+    {
+      std::lock_guard<std::mutex> lock(batch->mutex);
+      batch->evaluation_time += chunk_time;
+      if (exception && !batch->exception) batch->exception = exception;
+      batch->remaining -= end - start;
+      done = batch->remaining == 0;
+    }
+    if (done) {
+      if (batch->exception) {
+        batch->promise.set_exception(batch->exception);
+      }
+      else {
+        batch->promise.set_value(batch->values);
+      }
+    }
+  }
+}
+
+}
@@ -0,0 +1,141 @@
+#include "regression_experiments/expensive_function.h"
+
+#include "regression_experiments/benchmark_function_factory.h"
+
+#include <chrono>
+#include <cstdio>
+#include <sstream>
+#include <thread>
+
+namespace regression_experiments
+{
+
+ExpensiveFunction::ExpensiveFunction()
+  : cost(0), cost_mode("sleep"), nb_evaluators(1), chunk_size(1)
+{}
+
+Eigen::MatrixXd ExpensiveFunction::getLimits() const
+{
+  return function->getLimits();
+}
+
+double ExpensiveFunction::sample(const Eigen::VectorXd & input) const
+{
+  auto start = std::chrono::steady_clock::now();
+  double value;
+  if (command != "") {
+    value = runCommand(input);
+  }
+  else {
+    value = function->sample(input);
+  }
+  payCost(start);
+  return value;
+}
+
+Eigen::VectorXd ExpensiveFunction::sampleBatch(const Eigen::MatrixXd & inputs,
+                                               int nb_threads) const
+{
+  (void) nb_threads;
+  double batch_time;
+  Eigen::VectorXd values = pool->evaluate(inputs, &batch_time);
+  std::lock_guard<std::mutex> lock(thread_mutex);
+  thread_evaluation_times[std::this_thread::get_id()] += batch_time;
+  return values;
+}
+
+double ExpensiveFunction::getMax() const
+{
+  return function->getMax();
+}
+
+long ExpensiveFunction::getNbEvaluations() const
+{
+  return pool->getNbEvaluations();
+}
+
+double ExpensiveFunction::getEvaluationTime() const
+{
+  return pool->getEvaluationTime();
+}
+
+double ExpensiveFunction::getThreadEvaluationTime() const
+{
+  std::lock_guard<std::mutex> lock(thread_mutex);
+  auto it = thread_evaluation_times.find(std::this_thread::get_id());
+  return it == thread_evaluation_times.end() ? 0 : it->second;
+}
+
+double ExpensiveFunction::runCommand(const Eigen::VectorXd & input) const
+{
+  std::ostringstream oss;
+  oss.precision(17);
+  oss << command;
+  for (int dim = 0; dim < input.rows(); dim++) {
+    oss << " " << input(dim);
+  }
+  FILE * process = popen(oss.str().c_str(), "r");
+  if (process == NULL) {
+    throw std::runtime_error("ExpensiveFunction: failed to run '" + oss.str() + "'");
+  }
+  double value;
+  int nb_read = fscanf(process, "%lf", &value);
+  int status = pclose(process);
+  if (nb_read != 1 || status != 0) {
+    throw std::runtime_error("ExpensiveFunction: no value returned by '" + oss.str() + "'");
+  }
+  return value;
+}
+
+void ExpensiveFunction::payCost(std::chrono::steady_clock::time_point start) const
+{
+  auto end = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+    std::chrono::duration<double>(cost));
+  if (cost_mode == "sleep") {
+    std::this_thread::sleep_until(end);
+  }
+  else {
+    while (std::chrono::steady_clock::now() < end) {}
+  }
+}
+
+std::string ExpensiveFunction::class_name() const
+{
+  return "expensive";
+}
+
+void ExpensiveFunction::to_xml(std::ostream &out) const
+{
+  BenchmarkFunction::to_xml(out);
+  out << "<function>";
+  function->write(function->class_name(), out);
+  out << "</function>";
+  rosban_utils::xml_tools::write<double>     ("cost"         , cost         , out);
+  rosban_utils::xml_tools::write<std::string>("cost_mode"    , cost_mode    , out);
+  rosban_utils::xml_tools::write<std::string>("command"      , command      , out);
+  rosban_utils::xml_tools::write<int>        ("nb_evaluators", nb_evaluators, out);
+  rosban_utils::xml_tools::write<int>        ("chunk_size"   , chunk_size   , out);
+}
+
+void ExpensiveFunction::from_xml(TiXmlNode *node)
+{
+  BenchmarkFunction::from_xml(node);
+  TiXmlNode * function_node = node->FirstChild("function");
+  if (function_node == NULL) {
+    throw std::runtime_error("ExpensiveFunction::from_xml: no 'function' node");
+  }
+  function = BenchmarkFunctionFactory().build(function_node);
+  rosban_utils::xml_tools::try_read<double>     (node, "cost"         , cost         );
+  rosban_utils::xml_tools::try_read<std::string>(node, "cost_mode"    , cost_mode    );
+  rosban_utils::xml_tools::try_read<std::string>(node, "command"      , command      );
+  rosban_utils::xml_tools::try_read<int>        (node, "nb_evaluators", nb_evaluators);
+  rosban_utils::xml_tools::try_read<int>        (node, "chunk_size"   , chunk_size   );
+  if (cost_mode != "sleep" && cost_mode != "busy") {
+    throw std::runtime_error("ExpensiveFunction::from_xml: unknown cost_mode '" + cost_mode + "'");
+  }
+  pool.reset(new EvaluationPool([this](const Eigen::VectorXd & input)
+                                { return this->sample(input); },
+                                nb_evaluators, chunk_size));
+}
+
+}
@@ -0,0 +1,27 @@
+#include "regression_experiments/memory_usage.h"
+
+#include <fstream>
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+namespace regression_experiments
+{
+
+long getPeakRSS()
+{
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) return -1;
+  // ru_maxrss is in kB on Linux
+  return usage.ru_maxrss;
+}
+
+long getCurrentRSS()
+{
+  std::ifstream in("/proc/self/statm");
+  long size, resident;
+  if (!(in >> size >> resident)) return -1;
+  return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+}
@@ -0,0 +1,50 @@
+#include "regression_experiments/parallel.h"
+
+#include <algorithm>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace regression_experiments
+{
+
+void runParallel(int nb_items, int nb_threads,
+                 const std::function<void(int start, int end)> & task)
+{
+  if (nb_items <= 0) return;
+  nb_threads = std::max(1, std::min(nb_threads, nb_items));
+  if (nb_threads == 1) {
+    task(0, nb_items);
+    return;
+  }
+  std::exception_ptr error;
+  std::mutex error_mutex;
+  auto safe_task = [&](int start, int end)
+    {
+      try {
+        task(start, end);
+      }
+      catch (...) {
+        std::lock_guard<std::mutex> lock(error_mutex);
+        if (!error) error = std::current_exception();
+      }
+    };
+  // Ranges sizes differ by at most one item
+  std::vector<std::thread> threads;
+  int start = 0;
+  for (int thread_id = 0; thread_id < nb_threads; thread_id++) {
+    int end = start + nb_items / nb_threads + (thread_id < nb_items % nb_threads ? 1 : 0);
+    if (thread_id > 0) {
+      threads.push_back(std::thread(safe_task, start, end));
+    }
+    start = end;
+  }
+  safe_task(0, nb_items / nb_threads + (nb_items % nb_threads > 0 ? 1 : 0));
+  for (std::thread & thread : threads) {
+    thread.join();
+  }
+  if (error) std::rethrow_exception(error);
+}
+
+}
@@ -0,0 +1,137 @@
+#include "regression_experiments/perf_counters.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+
+namespace regression_experiments
+{
+
+PerfValues::PerfValues()
+  : cycles(-1), instructions(-1), l1d_misses(-1), llc_misses(-1),
+    branch_misses(-1), context_switches(-1)
+{}
+
+std::string PerfValues::csvHeader(const std::string & prefix)
+{
+  std::ostringstream oss;
+  oss << prefix << "cycles,"
+      << prefix << "instructions,"
+      << prefix << "l1d_misses,"
+      << prefix << "llc_misses,"
+      << prefix << "branch_misses,"
+      << prefix << "context_switches";
+  return oss.str();
+}
+
+void PerfValues::writeCsv(std::ostream & out) const
+{
+  out << cycles        << ","
+      << instructions  << ","
+      << l1d_misses    << ","
+      << llc_misses    << ","
+      << branch_misses << ","
+      << context_switches;
+}
+
+#ifdef __linux__
+
+/// Open a counter for the calling thread on any cpu, return -1 on failure
+static int openCounter(uint32_t type, uint64_t config)
+{
+  struct perf_event_attr attr;
+  std::memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = type;
+  attr.config = config;
+  attr.disabled = 1;
+  attr.inherit = 1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+  return (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+PerfCounters::PerfCounters()
+{
+  uint64_t l1d_miss = PERF_COUNT_HW_CACHE_L1D
+    | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+    | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+  fds.push_back(openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES));
+  fds.push_back(openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS));
+  fds.push_back(openCounter(PERF_TYPE_HW_CACHE, l1d_miss));
+  fds.push_back(openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES));
+  fds.push_back(openCounter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES));
+  fds.push_back(openCounter(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES));
+}
+
+PerfCounters::~PerfCounters()
+{
+  for (int fd : fds) {
+    if (fd >= 0) close(fd);
+  }
+}
+
+void PerfCounters::start()
+{
+  for (int fd : fds) {
+    if (fd < 0) continue;
+    ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+  }
+}
+
+/// Read a counter and scale it if it has been multiplexed
+static long readCounter(int fd)
+{
+  if (fd < 0) return -1;
+  // value, time_enabled, time_running
+  uint64_t data[3];
+  if (read(fd, data, sizeof(data)) != (ssize_t)sizeof(data)) return -1;
+  if (data[2] == 0) return data[1] == 0 ? 0 : -1;
+  if (data[2] < data[1]) {
+    return (long)((double)data[0] * data[1] / data[2]);
+  }
+  return (long)data[0];
+}
+
+PerfValues PerfCounters::stop()
+{
+  for (int fd : fds) {
+    if (fd >= 0) ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+  }
+  PerfValues values;
+  values.cycles           = readCounter(fds[0]);
+  values.instructions     = readCounter(fds[1]);
+  values.l1d_misses       = readCounter(fds[2]);
+  values.llc_misses       = readCounter(fds[3]);
+  values.branch_misses    = readCounter(fds[4]);
+  values.context_switches = readCounter(fds[5]);
+  return values;
+}
+
+#else
+
+PerfCounters::PerfCounters() {}
+PerfCounters::~PerfCounters() {}
+void PerfCounters::start() {}
+PerfValues PerfCounters::stop() { return PerfValues(); }
+
+#endif
+
+bool PerfCounters::isAvailable() const
+{
+  for (int fd : fds) {
+    if (fd >= 0) return true;
+  }
+  return false;
+}
+
+}
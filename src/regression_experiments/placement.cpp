@@ -0,0 +1,221 @@
+#include "regression_experiments/placement.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace regression_experiments
+{
+
+/// Parse a cpu (or node) list such as '0-3,8,10-11'
+static std::vector<int> parseCpuList(const std::string & str)
+{
+  std::vector<int> cpus;
+  std::istringstream iss(str);
+  std::string range;
+  while (std::getline(iss, range, ',')) {
+    if (range.empty() || range == "\n") continue;
+    size_t dash = range.find('-');
+    int first = std::stoi(range.substr(0, dash));
+    int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+    for (int cpu = first; cpu <= last; cpu++) {
+      cpus.push_back(cpu);
+    }
+  }
+  return cpus;
+}
+
+std::string cpusToString(const std::vector<int> & cpus)
+{
+  std::ostringstream oss;
+  size_t i = 0;
+  while (i < cpus.size()) {
+    size_t j = i;
+    while (j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1) j++;
+    if (i > 0) oss << ",";
+    oss << cpus[i];
+    if (j > i) oss << "-" << cpus[j];
+    i = j + 1;
+  }
+  return oss.str();
+}
+
+CpuTopology CpuTopology::detect()
+{
+  CpuTopology topology;
+  // Online node ids are not necessarily contiguous
+  std::ifstream online("/sys/devices/system/node/online");
+  std::string online_content;
+  std::getline(online, online_content);
+  for (int node_id : parseCpuList(online_content)) {
+    std::ifstream in("/sys/devices/system/node/node" + std::to_string(node_id) + "/cpulist");
+    if (!in.good()) continue;
+    std::string content;
+    std::getline(in, content);
+    std::vector<int> cpus = parseCpuList(content);
+    // Memory-only nodes have no cpus
+    if (cpus.size() > 0) {
+      topology.nodes.push_back(cpus);
+      topology.node_ids.push_back(node_id);
+    }
+  }
+  if (topology.nodes.size() == 0) {
+    int nb_cpus = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<int> cpus;
+    for (int cpu = 0; cpu < nb_cpus; cpu++) cpus.push_back(cpu);
+    topology.nodes.push_back(cpus);
+    topology.node_ids.push_back(-1);
+  }
+  return topology;
+}
+
+int CpuTopology::getNbNodes() const
+{
+  return nodes.size();
+}
+
+int CpuTopology::getNbCpus() const
+{
+  int total = 0;
+  for (const std::vector<int> & cpus : nodes) total += cpus.size();
+  return total;
+}
+
+const std::vector<int> & CpuTopology::getNodeCpus(int node) const
+{
+  return nodes.at(node);
+}
+
+int CpuTopology::getNodeId(int node) const
+{
+  return node_ids.at(node);
+}
+
+std::string CpuTopology::toString() const
+{
+  std::ostringstream oss;
+  for (size_t node = 0; node < nodes.size(); node++) {
+    if (node > 0) oss << ";";
+    oss << "node" << node_ids[node] << ":" << cpusToString(nodes[node]);
+  }
+  return oss.str();
+}
+
+PlacementPolicy parsePlacementPolicy(const std::string & name)
+{
+  if (name == "none"     ) return PlacementPolicy::None;
+  if (name == "compact"  ) return PlacementPolicy::Compact;
+  if (name == "spread"   ) return PlacementPolicy::Spread;
+  if (name == "numa_node") return PlacementPolicy::NumaNode;
+  throw std::runtime_error("parsePlacementPolicy: unknown policy '" + name + "'");
+}
+
+std::string toString(PlacementPolicy policy)
+{
+  switch (policy) {
+    case PlacementPolicy::None:     return "none";
+    case PlacementPolicy::Compact:  return "compact";
+    case PlacementPolicy::Spread:   return "spread";
+    case PlacementPolicy::NumaNode: return "numa_node";
+  }
+  throw std::logic_error("toString: unknown PlacementPolicy");
+}
+
+std::vector<WorkerPlacement> computePlacement(const CpuTopology & topology,
+                                              PlacementPolicy policy,
+                                              int nb_workers,
+                                              int threads_per_worker)
+{
+  std::vector<WorkerPlacement> placements(nb_workers);
+  int nb_nodes = topology.getNbNodes();
+  threads_per_worker = std::max(1, threads_per_worker);
+  switch (policy) {
+    case PlacementPolicy::None:
+      for (WorkerPlacement & placement : placements) placement.numa_node = -1;
+      break;
+    case PlacementPolicy::NumaNode:
+      for (int worker = 0; worker < nb_workers; worker++) {
+        int node = worker % nb_nodes;
+        placements[worker].numa_node = topology.getNodeId(node);
+        placements[worker].cpus = topology.getNodeCpus(node);
+      }
+      break;
+    case PlacementPolicy::Compact: {
+      // Concatenate the cpus of all nodes, workers take consecutive slices
+      std::vector<std::pair<int, int>> cpus;// (cpu, node)
+      for (int node = 0; node < nb_nodes; node++) {
+        for (int cpu : topology.getNodeCpus(node)) cpus.push_back({cpu, node});
+      }
+      for (int worker = 0; worker < nb_workers; worker++) {
+        for (int i = 0; i < threads_per_worker; i++) {
+          const std::pair<int, int> & entry = cpus[(worker * threads_per_worker + i) % cpus.size()];
+          placements[worker].cpus.push_back(entry.first);
+          if (i == 0) placements[worker].numa_node = topology.getNodeId(entry.second);
+        }
+      }
+      break;
+    }
+    case PlacementPolicy::Spread: {
+      // Worker w goes on node w % nb_nodes, slices are consecutive inside the node
+      std::vector<int> used(nb_nodes, 0);
+      for (int worker = 0; worker < nb_workers; worker++) {
+        int node = worker % nb_nodes;
+        const std::vector<int> & node_cpus = topology.getNodeCpus(node);
+        placements[worker].numa_node = topology.getNodeId(node);
+        for (int i = 0; i < threads_per_worker; i++) {
+          placements[worker].cpus.push_back(node_cpus[used[node] % node_cpus.size()]);
+          used[node]++;
+        }
+      }
+      break;
+    }
+  }
+  // Sorting cpus for readability
+  for (WorkerPlacement & placement : placements) {
+    std::sort(placement.cpus.begin(), placement.cpus.end());
+    placement.cpus.erase(std::unique(placement.cpus.begin(), placement.cpus.end()),
+                         placement.cpus.end());
+  }
+  return placements;
+}
+
+bool applyPlacement(const WorkerPlacement & placement)
+{
+#ifdef __linux__
+  bool success = true;
+  if (placement.cpus.size() > 0) {
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    for (int cpu : placement.cpus) CPU_SET(cpu, &cpu_set);
+    success = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) == 0;
+  }
+  if (placement.numa_node >= 0) {
+    // MPOL_PREFERRED from linux/mempolicy.h, libnuma is not required
+    const int mpol_preferred = 1;
+    unsigned long node_mask[16] = {0};
+    const unsigned long bits = 8 * sizeof(unsigned long);
+    // The kernel reads maxnode - 1 bits of the mask
+    if (placement.numa_node < (int)(16 * bits) - 1) {
+      node_mask[placement.numa_node / bits] = 1ul << (placement.numa_node % bits);
+      success &= syscall(SYS_set_mempolicy, mpol_preferred, node_mask, 16 * bits) == 0;
+    }
+    else {
+      success = false;
+    }
+  }
+  return success;
+#else
+  return placement.cpus.size() == 0;
+#endif
+}
+
+}
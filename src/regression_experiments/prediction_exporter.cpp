@@ -0,0 +1,145 @@
+#include "regression_experiments/prediction_exporter.h"
+
+#include <cmath>
+#include <stdexcept>
+
+using rosban_fa::FunctionApproximator;
+
+namespace regression_experiments
+{
+
+PredictionExporter::PredictionExporter(const std::string & path, int input_dim_, int chunk_size_)
+  : buffered_lines(0), chunk_size(chunk_size_), input_dim(input_dim_)
+{
+  if (chunk_size <= 0) {
+    throw std::logic_error("PredictionExporter: chunk_size should be strictly positive");
+  }
+  out.open(path);
+  if (!out.good()) {
+    throw std::runtime_error("PredictionExporter: failed to open '" + path + "'");
+  }
+  buffer.precision(10);
+  out << "type";
+  for (int dim = 0; dim < input_dim; dim++) {
+    out << ",input_" << dim;
+  }
+  out << ",mean,min,max";
+  for (int dim = 0; dim < input_dim; dim++) {
+    out << ",gradient_" << dim;
+  }
+  out << "\n";
+}
+
+PredictionExporter::~PredictionExporter()
+{
+  flush();
+  out.close();
+}
+
+void PredictionExporter::writeObservations(const Eigen::MatrixXd & inputs,
+                                           const Eigen::VectorXd & outputs)
+{
+  Eigen::VectorXd no_gradient = Eigen::VectorXd::Zero(input_dim);
+  for (int i = 0; i < inputs.cols(); i++) {
+    writeLine("observation", inputs.col(i), outputs(i), 0, 0, no_gradient);
+  }
+}
+
+void PredictionExporter::writePredictions(const Eigen::MatrixXd & points,
+                                          const Eigen::VectorXd & means,
+                                          const Eigen::VectorXd & vars,
+                                          const Eigen::MatrixXd & gradients)
+{
+  for (int point = 0; point < points.cols(); point++) {
+    // Getting +- 2 stddev
+    double interval = 2 * std::sqrt(vars(point));
+    writeLine("prediction", points.col(point), means(point),
+              means(point) - interval, means(point) + interval, gradients.col(point));
+  }
+}
+
+long PredictionExporter::exportGrid(std::shared_ptr<const FunctionApproximator> fa,
+                                    const Eigen::MatrixXd & limits,
+                                    const std::vector<int> & points_by_dim,
+                                    const std::map<int, double> & fixed_values)
+{
+  // Checking consistency
+  if (limits.rows() != input_dim || (int)points_by_dim.size() != input_dim) {
+    throw std::logic_error("PredictionExporter::exportGrid: inconsistent dimensions");
+  }
+  for (const auto & entry : fixed_values) {
+    if (entry.first < 0 || entry.first >= input_dim) {
+      throw std::logic_error("PredictionExporter::exportGrid: invalid fixed dimension");
+    }
+  }
+  // Free dimensions and number of points along each of them
+  std::vector<int> free_dims;
+  std::vector<long> intervals;
+  long total_points = 1;
+  for (int dim = 0; dim < input_dim; dim++) {
+    if (fixed_values.count(dim) > 0) continue;
+    free_dims.push_back(dim);
+    intervals.push_back(total_points);
+    total_points *= points_by_dim[dim];
+  }
+  // Fixed values and default values are shared by all points
+  Eigen::VectorXd input(input_dim);
+  for (int dim = 0; dim < input_dim; dim++) {
+    auto it = fixed_values.find(dim);
+    if (it != fixed_values.end()) {
+      input(dim) = it->second;
+    }
+    else {
+      input(dim) = (limits(dim, 0) + limits(dim, 1)) / 2;
+    }
+  }
+  // Generating, predicting and writing points one by one, only one chunk is in memory
+  Eigen::VectorXd gradient;
+  for (long point = 0; point < total_points; point++) {
+    for (size_t i = 0; i < free_dims.size(); i++) {
+      int dim = free_dims[i];
+      if (points_by_dim[dim] == 1) continue;
+      long dim_index = (point / intervals[i]) % points_by_dim[dim];
+      double step_size = (limits(dim, 1) - limits(dim, 0)) / (points_by_dim[dim] - 1);
+      input(dim) = limits(dim, 0) + step_size * dim_index;
+    }
+    double mean, var;
+    fa->predict(input, mean, var);
+    fa->gradient(input, gradient);
+    double interval = 2 * std::sqrt(var);
+    writeLine("prediction", input, mean, mean - interval, mean + interval, gradient);
+  }
+  return total_points;
+}
+
+void PredictionExporter::flush()
+{
+  if (buffered_lines == 0) return;
+  const std::string & content = buffer.str();
+  out.write(content.data(), content.size());
+  out.flush();
+  buffer.str("");
+  buffered_lines = 0;
+}
+
+void PredictionExporter::writeLine(const std::string & type,
+                                   const Eigen::VectorXd & input,
+                                   double mean, double min, double max,
+                                   const Eigen::VectorXd & gradient)
+{
+  buffer << type;
+  for (int dim = 0; dim < input_dim; dim++) {
+    buffer << "," << input(dim);
+  }
+  buffer << "," << mean << "," << min << "," << max;
+  for (int dim = 0; dim < input_dim; dim++) {
+    buffer << "," << gradient(dim);
+  }
+  buffer << "\n";
+  buffered_lines++;
+  if (buffered_lines >= chunk_size) {
+    flush();
+  }
+}
+
+}
@@ -0,0 +1,322 @@
+#include "regression_experiments/progress_monitor.h"
+
+#include "regression_experiments/memory_usage.h"
+#include "regression_experiments/trace_recorder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace regression_experiments
+{
+
+/// Fit duration = coeff * size^exponent with least squares on the logarithms.
+/// With a single size, the duration is assumed to be proportional to the size.
+/// Return false if there are no durations.
+static bool fitPowerLaw(const std::vector<std::pair<double, double>> & durations,
+                        double & coeff, double & exponent)
+{
+  if (durations.empty()) return false;
+  double sum_x = 0, sum_y = 0, sum_xx = 0, sum_xy = 0;
+  std::set<double> sizes;
+  for (const auto & entry : durations) {
+    double x = std::log(std::max(entry.first, 1e-9));
+    double y = std::log(std::max(entry.second, 1e-9));
+    sum_x += x;
+    sum_y += y;
+    sum_xx += x * x;
+    sum_xy += x * y;
+    sizes.insert(entry.first);
+  }
+  double n = durations.size();
+  if (sizes.size() < 2) {
+    exponent = 1;
+  }
+  else {
+    exponent = (n * sum_xy - sum_x * sum_y) / (n * sum_xx - sum_x * sum_x);
+  }
+  coeff = std::exp((sum_y - exponent * sum_x) / n);
+  return true;
+}
+
+ProgressMonitor::WorkerStatus::WorkerStatus()
+  : busy(false), size(0), nb_completed(0)
+{}
+
+ProgressMonitor::ProgressMonitor(int nb_workers)
+  : creation(Clock::now()), workers(nb_workers), nb_completed(0), finished(false),
+    period(5), socket_fd(-1), stop_requested(false)
+{}
+
+ProgressMonitor::~ProgressMonitor()
+{
+  stop();
+}
+
+void ProgressMonitor::plan(const std::string & group, double size, int nb_cells)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  pending[group][size] += nb_cells;
+}
+
+void ProgressMonitor::cancel(const std::string & group, double size, int nb_cells)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  int & nb_pending = pending[group][size];
+  nb_pending = std::max(0, nb_pending - nb_cells);
+}
+
+void ProgressMonitor::startCell(int worker_id, const std::string & group, double size,
+                                const std::string & description)
+{
+  Clock::time_point now = Clock::now();
+  std::lock_guard<std::mutex> lock(mutex);
+  WorkerStatus & worker = workers.at(worker_id);
+  worker.busy = true;
+  worker.group = group;
+  worker.size = size;
+  worker.description = description;
+  worker.cell_start = now;
+  int & nb_pending = pending[group][size];
+  nb_pending = std::max(0, nb_pending - 1);
+}
+
+void ProgressMonitor::endCell(int worker_id)
+{
+  Clock::time_point now = Clock::now();
+  std::lock_guard<std::mutex> lock(mutex);
+  WorkerStatus & worker = workers.at(worker_id);
+  if (!worker.busy) return;
+  double duration = std::chrono::duration<double>(now - worker.cell_start).count();
+  durations[worker.group].push_back(std::make_pair(worker.size, duration));
+  worker.busy = false;
+  worker.nb_completed++;
+  nb_completed++;
+}
+
+void ProgressMonitor::start(const std::string & status_path_,
+                            const std::string & socket_path_,
+                            double period_)
+{
+  if (thread.joinable()) {
+    throw std::logic_error("ProgressMonitor::start: already started");
+  }
+  status_path = status_path_;
+  socket_path = socket_path_;
+  period = period_;
+  if (socket_path != "") {
+    struct sockaddr_un address;
+    if (socket_path.size() >= sizeof(address.sun_path)) {
+      throw std::runtime_error("ProgressMonitor: socket path too long '" + socket_path + "'");
+    }
+    socket_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (socket_fd < 0) {
+      throw std::runtime_error("ProgressMonitor: failed to create socket");
+    }
+    address.sun_family = AF_UNIX;
+    snprintf(address.sun_path, sizeof(address.sun_path), "%s", socket_path.c_str());
+    // A socket left by a previous run would make bind fail
+    unlink(socket_path.c_str());
+    if (bind(socket_fd, (struct sockaddr *)&address, sizeof(address)) != 0
+        || listen(socket_fd, 8) != 0) {
+      close(socket_fd);
+      socket_fd = -1;
+      throw std::runtime_error("ProgressMonitor: failed to listen on '" + socket_path + "'");
+    }
+  }
+  stop_requested = false;
+  thread = std::thread(&ProgressMonitor::run, this);
+}
+
+void ProgressMonitor::stop()
+{
+  if (!thread.joinable()) return;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    finished = true;
+  }
+  stop_requested = true;
+  thread.join();
+  if (status_path != "") {
+    writeStatus();
+  }
+  if (socket_fd >= 0) {
+    close(socket_fd);
+    unlink(socket_path.c_str());
+    socket_fd = -1;
+  }
+}
+
+std::string ProgressMonitor::getStatus() const
+{
+  Clock::time_point now = Clock::now();
+  long peak_rss = getPeakRSS();
+  long current_rss = getCurrentRSS();
+  std::lock_guard<std::mutex> lock(mutex);
+  double elapsed = std::chrono::duration<double>(now - creation).count();
+  // Cost models: group -> (coeff, exponent), groups without completed cells
+  // use a model fitted on all the cells
+  std::map<std::string, std::pair<double, double>> models;
+  Durations all;
+  for (const auto & entry : durations) {
+    double coeff, exponent;
+    if (fitPowerLaw(entry.second, coeff, exponent)) {
+      models[entry.first] = std::make_pair(coeff, exponent);
+    }
+    all.insert(all.end(), entry.second.begin(), entry.second.end());
+  }
+  double all_coeff = -1, all_exponent = -1;
+  bool has_model = fitPowerLaw(all, all_coeff, all_exponent);
+  // Estimated duration of a cell [s], -1 if no cell has been completed
+  auto predict_duration = [&](const std::string & group, double size) -> double
+    {
+      auto it = models.find(group);
+      if (it != models.end()) return it->second.first * std::pow(size, it->second.second);
+      if (has_model) return all_coeff * std::pow(size, all_exponent);
+      return -1.0;
+    };
+  // Remaining work according to the cost models
+  int nb_pending = 0;
+  int nb_running = 0;
+  double remaining_work = 0;
+  bool eta_known = true;
+  std::ostringstream groups;
+  bool first_group = true;
+  std::set<std::string> names;
+  for (const auto & entry : pending) names.insert(entry.first);
+  for (const auto & entry : durations) names.insert(entry.first);
+  for (const std::string & name : names) {
+    int group_pending = 0;
+    auto pending_it = pending.find(name);
+    if (pending_it != pending.end()) {
+      for (const auto & size_entry : pending_it->second) {
+        if (size_entry.second == 0) continue;
+        double prediction = predict_duration(name, size_entry.first);
+        if (prediction < 0) eta_known = false;
+        remaining_work += size_entry.second * prediction;
+        group_pending += size_entry.second;
+      }
+    }
+    nb_pending += group_pending;
+    int group_completed = 0;
+    double coeff = -1, exponent = -1;
+    auto durations_it = durations.find(name);
+    if (durations_it != durations.end()) {
+      group_completed = durations_it->second.size();
+      coeff = models[name].first;
+      exponent = models[name].second;
+    }
+    if (!first_group) groups << ",";
+    groups << "{\"name\":\"" << escapeJson(name) << "\""
+           << ",\"completed\":" << group_completed
+           << ",\"pending\":" << group_pending
+           << ",\"coefficient\":" << coeff
+           << ",\"exponent\":" << exponent << "}";
+    first_group = false;
+  }
+  std::ostringstream workers_json;
+  for (size_t worker_id = 0; worker_id < workers.size(); worker_id++) {
+    const WorkerStatus & worker = workers[worker_id];
+    double cell_time = 0;
+    if (worker.busy) {
+      nb_running++;
+      cell_time = std::chrono::duration<double>(now - worker.cell_start).count();
+      double prediction = predict_duration(worker.group, worker.size);
+      if (prediction < 0) eta_known = false;
+      remaining_work += std::max(0.0, prediction - cell_time);
+    }
+    if (worker_id > 0) workers_json << ",";
+    workers_json << "{\"id\":" << worker_id
+                 << ",\"busy\":" << (worker.busy ? "true" : "false")
+                 << ",\"cell\":\"" << (worker.busy ? escapeJson(worker.description) : "") << "\""
+                 << ",\"cell_time\":" << cell_time
+                 << ",\"completed\":" << worker.nb_completed << "}";
+  }
+  // Workers are assumed to share the remaining work evenly
+  double eta = eta_known ? remaining_work / workers.size() : -1;
+  if (nb_pending + nb_running == 0) eta = 0;
+  double cells_per_hour = elapsed > 0 ? nb_completed / elapsed * 3600 : 0;
+  std::ostringstream oss;
+  oss << "{\"finished\":" << (finished ? "true" : "false")
+      << ",\"elapsed\":" << elapsed
+      << ",\"completed_cells\":" << nb_completed
+      << ",\"running_cells\":" << nb_running
+      << ",\"remaining_cells\":" << (nb_pending + nb_running)
+      << ",\"cells_per_hour\":" << cells_per_hour
+      << ",\"eta\":" << eta
+      << ",\"peak_rss_kb\":" << peak_rss
+      << ",\"current_rss_kb\":" << current_rss
+      << ",\"workers\":[" << workers_json.str() << "]"
+      << ",\"groups\":[" << groups.str() << "]}";
+  return oss.str();
+}
+
+void ProgressMonitor::run()
+{
+  Clock::time_point next_write = Clock::now();
+  while (!stop_requested) {
+    if (status_path != "" && Clock::now() >= next_write) {
+      writeStatus();
+      next_write += std::chrono::microseconds((long)(period * 1e6));
+    }
+    // Short timeout, so that stop does not have to wait for the period
+    struct pollfd fds;
+    fds.fd = socket_fd;
+    fds.events = POLLIN;
+    int nb_ready = poll(&fds, socket_fd >= 0 ? 1 : 0, 200);
+    if (nb_ready > 0 && (fds.revents & POLLIN)) {
+      answerConnection();
+    }
+  }
+}
+
+void ProgressMonitor::writeStatus() const
+{
+  std::string tmp_path = status_path + ".tmp";
+  {
+    std::ofstream out(tmp_path);
+    if (!out.good()) return;
+    out << getStatus() << std::endl;
+  }
+  std::rename(tmp_path.c_str(), status_path.c_str());
+}
+
+void ProgressMonitor::answerConnection() const
+{
+  int client_fd = accept(socket_fd, NULL, NULL);
+  if (client_fd < 0) return;
+  // HTTP clients send a request first, others are answered directly
+  std::string request;
+  struct pollfd fds;
+  fds.fd = client_fd;
+  fds.events = POLLIN;
+  if (poll(&fds, 1, 100) > 0) {
+    char buffer[1024];
+    ssize_t nb_read = recv(client_fd, buffer, sizeof(buffer), 0);
+    if (nb_read > 0) request.assign(buffer, nb_read);
+  }
+  std::string response = getStatus() + "\n";
+  if (request.compare(0, 4, "GET ") == 0) {
+    response = "HTTP/1.0 200 OK\r\nContent-Type: application/json\r\nContent-Length: "
+      + std::to_string(response.size()) + "\r\nConnection: close\r\n\r\n" + response;
+  }
+  size_t sent = 0;
+  while (sent < response.size()) {
+    ssize_t nb_sent = send(client_fd, response.data() + sent, response.size() - sent,
+                           MSG_NOSIGNAL);
+    if (nb_sent <= 0) break;
+    sent += nb_sent;
+  }
+  close(client_fd);
+}
+
+}
@@ -0,0 +1,316 @@
+#include "regression_experiments/random_function.h"
+
+#include "regression_experiments/parallel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <numeric>
+#include <stdexcept>
+
+namespace regression_experiments
+{
+
+/// Replace values by their cosine using Eigen packets, since std::cos is not
+/// vectorized for doubles. Arguments are reduced to r in [-pi, pi], then
+/// cos(r) = 2 cos(r/2)^2 - 1 where cos(r/2) uses a Taylor polynomial of degree
+/// 20, absolute error is below 1e-15 for |x| < 1e6. There is no branch and
+/// results do not depend on the position of the values in the array.
+static void vectorCos(double * data, long n)
+{
+  const double inv_two_pi = 0.15915494309189535;
+  // Pi split in three parts, products with the two first ones are exact
+  const double pi_hi = 3.141592651605606;
+  const double pi_mid = 1.9841871479187034e-09;
+  const double pi_lo = 1.1442377452219664e-17;
+  // Adding and removing 1.5 * 2^52 rounds to the nearest integer
+  const double round = 6755399441055744.0;
+  Eigen::Map<Eigen::ArrayXd> values(data, n);
+  Eigen::ArrayXd k = (values * inv_two_pi + round) - round;
+  // (r / 2)^2
+  Eigen::ArrayXd t2 = (((values * 0.5 - k * pi_hi) - k * pi_mid) - k * pi_lo).square();
+  // cos(r / 2) with a single expression, so that Eigen uses a single loop
+  values = 2 * ((((((((((1.0 / 2432902008176640000.0 * t2
+                         - 1.0 / 6402373705728000.0) * t2
+                        + 1.0 / 20922789888000.0) * t2
+                       - 1.0 / 87178291200.0) * t2
+                      + 1.0 / 479001600.0) * t2
+                     - 1.0 / 3628800.0) * t2
+                    + 1.0 / 40320.0) * t2
+                   - 1.0 / 720.0) * t2
+                  + 1.0 / 24.0) * t2
+                 - 0.5) * t2
+                + 1.0).square() - 1;
+}
+
+RandomFunction::RandomFunction(int nb_dimensions_, uint32_t seed_)
+  : nb_dimensions(nb_dimensions_), seed(seed_), group_size(2), nb_features(50),
+    length_scale(0.2), nb_discontinuities(0), discontinuity_amplitude(1)
+{
+  generate();
+}
+
+void RandomFunction::setSeed(uint32_t new_seed)
+{
+  seed = new_seed;
+  generate();
+}
+
+Eigen::MatrixXd RandomFunction::getLimits() const
+{
+  Eigen::MatrixXd limits(nb_dimensions, 2);
+  limits.col(0) = Eigen::VectorXd::Zero(nb_dimensions);
+  limits.col(1) = Eigen::VectorXd::Ones(nb_dimensions);
+  return limits;
+}
+
+double RandomFunction::sample(const Eigen::VectorXd & input) const
+{
+  Eigen::MatrixXd inputs = input;
+  return evaluate(inputs)(0);
+}
+
+Eigen::VectorXd RandomFunction::sampleBatch(const Eigen::MatrixXd & inputs,
+                                            int nb_threads) const
+{
+  // Chunks are small enough for the projections to stay in cache
+  int chunk_size = 256;
+  int nb_inputs = inputs.cols();
+  int nb_chunks = (nb_inputs + chunk_size - 1) / chunk_size;
+  Eigen::VectorXd values(nb_inputs);
+  runParallel(nb_chunks, nb_threads, [&](int start, int end)
+              {
+                for (int chunk = start; chunk < end; chunk++) {
+                  int first = chunk * chunk_size;
+                  int size = std::min(chunk_size, nb_inputs - first);
+                  values.segment(first, size) = evaluate(inputs.middleCols(first, size));
+                }
+              });
+  return values;
+}
+
+double RandomFunction::getMax() const
+{
+  return max_value;
+}
+
+std::string RandomFunction::class_name() const
+{
+  return "random_function";
+}
+
+void RandomFunction::to_xml(std::ostream &out) const
+{
+  BenchmarkFunction::to_xml(out);
+  rosban_utils::xml_tools::write<int>   ("nb_dimensions"          , nb_dimensions          , out);
+  rosban_utils::xml_tools::write<int>   ("seed"                   , seed                   , out);
+  rosban_utils::xml_tools::write<int>   ("group_size"             , group_size             , out);
+  rosban_utils::xml_tools::write<int>   ("nb_features"            , nb_features            , out);
+  rosban_utils::xml_tools::write<double>("length_scale"           , length_scale           , out);
+  rosban_utils::xml_tools::write<int>   ("nb_discontinuities"     , nb_discontinuities     , out);
+  rosban_utils::xml_tools::write<double>("discontinuity_amplitude", discontinuity_amplitude, out);
+}
+
+void RandomFunction::from_xml(TiXmlNode *node)
+{
+  BenchmarkFunction::from_xml(node);
+  int read_seed = seed;
+  rosban_utils::xml_tools::try_read<int>   (node, "nb_dimensions"          , nb_dimensions          );
+  rosban_utils::xml_tools::try_read<int>   (node, "seed"                   , read_seed              );
+  rosban_utils::xml_tools::try_read<int>   (node, "group_size"             , group_size             );
+  rosban_utils::xml_tools::try_read<int>   (node, "nb_features"            , nb_features            );
+  rosban_utils::xml_tools::try_read<double>(node, "length_scale"           , length_scale           );
+  rosban_utils::xml_tools::try_read<int>   (node, "nb_discontinuities"     , nb_discontinuities     );
+  rosban_utils::xml_tools::try_read<double>(node, "discontinuity_amplitude", discontinuity_amplitude);
+  seed = read_seed;
+  generate();
+}
+
+void RandomFunction::generate()
+{
+  if (nb_dimensions < 1 || group_size < 1 || nb_features < 1 || length_scale <= 0
+      || nb_discontinuities < 0) {
+    throw std::runtime_error("RandomFunction: invalid parameters");
+  }
+  RandomStream stream(seed, 0, 0, RandomPurpose::FunctionGeneration);
+  // Shuffling dimensions (Fisher-Yates)
+  std::vector<int> dims(nb_dimensions);
+  std::iota(dims.begin(), dims.end(), 0);
+  Eigen::VectorXd shuffle = stream.withSubstream(0).uniform(nb_dimensions);
+  for (int i = nb_dimensions - 1; i > 0; i--) {
+    int j = std::min(i, (int)((1 - shuffle(i)) * (i + 1)));
+    std::swap(dims[i], dims[j]);
+  }
+  // Features are scaled so that the variance of the sum is close to 1
+  int nb_components = (nb_dimensions + group_size - 1) / group_size;
+  double weight_std = std::sqrt(2.0 / (nb_features * nb_components));
+  components.clear();
+  components.resize(nb_components);
+  max_value = 0;
+  for (int c = 0; c < nb_components; c++) {
+    Component & component = components[c];
+    int size = std::min(group_size, nb_dimensions - c * group_size);
+    component.dims.assign(dims.begin() + c * group_size, dims.begin() + c * group_size + size);
+    Eigen::VectorXd g = stream.withSubstream(1 + 2 * c).gaussian(nb_features * (size + 1)
+                                                                + nb_discontinuities);
+    Eigen::VectorXd u = stream.withSubstream(2 + 2 * c).uniform(nb_features
+                                                               + 2 * nb_discontinuities);
+    // Frequencies of the features follow the spectral density of the kernel
+    component.frequencies.resize(nb_features, size);
+    component.phases.resize(nb_features);
+    component.weights.resize(nb_features);
+    for (int f = 0; f < nb_features; f++) {
+      for (int k = 0; k < size; k++) {
+        component.frequencies(f, k) = g(f * size + k) / length_scale;
+      }
+      component.weights(f) = weight_std * g(nb_features * size + f);
+      component.phases(f) = 2 * M_PI * u(f);
+    }
+    for (int s = 0; s < nb_discontinuities; s++) {
+      double u_dim = u(nb_features + 2 * s);
+      double u_threshold = u(nb_features + 2 * s + 1);
+      component.step_dims.push_back(std::min(size - 1, (int)((1 - u_dim) * size)));
+      component.thresholds.push_back(0.1 + 0.8 * u_threshold);
+      component.heights.push_back(discontinuity_amplitude * g(nb_features * (size + 1) + s));
+    }
+    component.max = computeMax(component);
+    max_value += component.max;
+  }
+}
+
+Eigen::VectorXd RandomFunction::evaluate(const Component & component,
+                                         const Eigen::MatrixXd & group_inputs) const
+{
+  // One column per feature, operations are done in the same order for all
+  // inputs, so that values do not depend on the size of the batch
+  int nb_inputs = group_inputs.cols();
+  Eigen::MatrixXd features(nb_inputs, component.phases.size());
+  for (int f = 0; f < features.cols(); f++) {
+    features.col(f).setConstant(component.phases(f));
+    for (int k = 0; k < group_inputs.rows(); k++) {
+      features.col(f) += component.frequencies(f, k) * group_inputs.row(k).transpose();
+    }
+  }
+  vectorCos(features.data(), features.size());
+  Eigen::VectorXd values = Eigen::VectorXd::Zero(nb_inputs);
+  for (int f = 0; f < features.cols(); f++) {
+    values += component.weights(f) * features.col(f);
+  }
+  for (size_t s = 0; s < component.thresholds.size(); s++) {
+    int k = component.step_dims[s];
+    for (int i = 0; i < group_inputs.cols(); i++) {
+      if (group_inputs(k, i) > component.thresholds[s]) {
+        values(i) += component.heights[s];
+      }
+    }
+  }
+  return values;
+}
+
+Eigen::VectorXd RandomFunction::evaluate(const Eigen::MatrixXd & inputs) const
+{
+  Eigen::VectorXd values = Eigen::VectorXd::Zero(inputs.cols());
+  Eigen::MatrixXd group_inputs;
+  for (const Component & component : components) {
+    group_inputs.resize(component.dims.size(), inputs.cols());
+    for (size_t k = 0; k < component.dims.size(); k++) {
+      group_inputs.row(k) = inputs.row(component.dims[k]);
+    }
+    values += evaluate(component, group_inputs);
+  }
+  return values;
+}
+
+double RandomFunction::computeMax(const Component & component) const
+{
+  int size = component.dims.size();
+  // Grid spacing is a fraction of the length scale, limited to 2^22 points
+  int nb_points = std::max(33, (int)std::ceil(8 / length_scale) + 1);
+  nb_points = std::min(nb_points, (int)std::pow(2.0, 22.0 / size));
+  std::vector<std::vector<double>> axes(size);
+  for (int k = 0; k < size; k++) {
+    for (int i = 0; i < nb_points; i++) {
+      axes[k].push_back(i / (double)(nb_points - 1));
+    }
+  }
+  // Both sides of each step are part of the grid
+  for (size_t s = 0; s < component.thresholds.size(); s++) {
+    double threshold = component.thresholds[s];
+    axes[component.step_dims[s]].push_back(threshold);
+    axes[component.step_dims[s]].push_back(std::nextafter(threshold, 2.0));
+  }
+  long total_points = 1;
+  for (int k = 0; k < size; k++) {
+    total_points *= axes[k].size();
+  }
+  // Evaluating the grid by chunks and keeping the best points as starts
+  int nb_starts = 8;
+  long chunk_size = 4096;
+  std::vector<std::pair<double, long>> best;
+  Eigen::MatrixXd chunk;
+  for (long first = 0; first < total_points; first += chunk_size) {
+    long size_chunk = std::min(chunk_size, total_points - first);
+    chunk.resize(size, size_chunk);
+    for (long i = 0; i < size_chunk; i++) {
+      long index = first + i;
+      for (int k = 0; k < size; k++) {
+        chunk(k, i) = axes[k][index % axes[k].size()];
+        index /= axes[k].size();
+      }
+    }
+    Eigen::VectorXd values = evaluate(component, chunk);
+    for (long i = 0; i < size_chunk; i++) {
+      best.push_back(std::make_pair(values(i), first + i));
+    }
+    if ((int)best.size() > nb_starts) {
+      std::nth_element(best.begin(), best.begin() + nb_starts, best.end(),
+                       std::greater<std::pair<double, long>>());
+      best.resize(nb_starts);
+    }
+  }
+  // Refining the best points with compass search
+  double max = best[0].first;
+  for (const auto & start : best) {
+    Eigen::MatrixXd point(size, 1);
+    long index = start.second;
+    for (int k = 0; k < size; k++) {
+      point(k, 0) = axes[k][index % axes[k].size()];
+      index /= axes[k].size();
+    }
+    double value = start.first;
+    double step = 1.0 / (nb_points - 1);
+    for (int iteration = 0; iteration < 1000 && step > 1e-10; iteration++) {
+      bool improved = false;
+      for (int k = 0; k < size; k++) {
+        for (int direction : {-1, 1}) {
+          Eigen::MatrixXd candidate = point;
+          candidate(k, 0) = std::max(0.0, std::min(1.0, point(k, 0) + direction * step));
+          double candidate_value = evaluate(component, candidate)(0);
+          if (candidate_value > value) {
+            point = candidate;
+            value = candidate_value;
+            improved = true;
+          }
+        }
+      }
+      if (!improved) step /= 2;
+    }
+    max = std::max(max, value);
+  }
+  return max;
+}
+
+std::map<std::string, std::shared_ptr<const BenchmarkFunction>>
+buildRandomSuite(const RandomFunction & prototype, int nb_functions, uint32_t first_seed)
+{
+  std::map<std::string, std::shared_ptr<const BenchmarkFunction>> functions;
+  for (int i = 0; i < nb_functions; i++) {
+    uint32_t function_seed = first_seed + i;
+    std::shared_ptr<RandomFunction> function(new RandomFunction(prototype));
+    function->setSeed(function_seed);
+    functions["random_" + std::to_string(function_seed)] = function;
+  }
+  return functions;
+}
+
+}
@@ -0,0 +1,366 @@
+#include "regression_experiments/result_aggregator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+namespace regression_experiments
+{
+
+/// Split a csv line, no quoting is used by the benchmarks
+static void splitLine(const std::string & line, std::vector<std::string> & fields)
+{
+  fields.clear();
+  size_t start = 0;
+  while (true) {
+    size_t end = line.find(',', start);
+    if (end == std::string::npos) {
+      fields.push_back(line.substr(start));
+      break;
+    }
+    fields.push_back(line.substr(start, end - start));
+    start = end + 1;
+  }
+  // Handling files with windows line endings
+  if (fields.size() > 0 && fields.back().size() > 0 && fields.back().back() == '\r') {
+    fields.back().pop_back();
+  }
+}
+
+/// Quantile 0.975 of the Student distribution with 'df' degrees of freedom
+static double student975(int df)
+{
+  static const double table[] = {
+    12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+    2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+    2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+  };
+  if (df <= 0) return std::numeric_limits<double>::quiet_NaN();
+  if (df <= 30) return table[df - 1];
+  // Asymptotic expansion
+  return 1.95996 + 2.37227 / df;
+}
+
+P2Quantile::P2Quantile(double p_)
+  : p(p_), count(0)
+{
+  double init_desired[5] = {0, 2 * p, 4 * p, 2 + 2 * p, 4};
+  double init_increments[5] = {0, p / 2, p, (1 + p) / 2, 1};
+  for (int i = 0; i < 5; i++) {
+    heights[i] = 0;
+    positions[i] = i;
+    desired[i] = init_desired[i];
+    increments[i] = init_increments[i];
+  }
+}
+
+void P2Quantile::add(double value)
+{
+  if (count < 5) {
+    heights[count] = value;
+    count++;
+    if (count == 5) std::sort(heights, heights + 5);
+    return;
+  }
+  count++;
+  // Find the cell of the value and update extreme markers
+  int k;
+  if (value < heights[0]) {
+    heights[0] = value;
+    k = 0;
+  }
+  else if (value >= heights[4]) {
+    heights[4] = value;
+    k = 3;
+  }
+  else {
+    k = 0;
+    while (k < 3 && value >= heights[k + 1]) k++;
+  }
+  for (int i = k + 1; i < 5; i++) positions[i] += 1;
+  for (int i = 0; i < 5; i++) desired[i] += increments[i];
+  // Adjust the heights of the middle markers
+  for (int i = 1; i < 4; i++) {
+    double d = desired[i] - positions[i];
+    if ((d >= 1 && positions[i + 1] - positions[i] > 1) ||
+        (d <= -1 && positions[i - 1] - positions[i] < -1)) {
+      int sign = d >= 0 ? 1 : -1;
+      // Piecewise parabolic prediction
+      double h = heights[i] + sign / (positions[i + 1] - positions[i - 1]) *
+        ((positions[i] - positions[i - 1] + sign) * (heights[i + 1] - heights[i]) /
+         (positions[i + 1] - positions[i]) +
+         (positions[i + 1] - positions[i] - sign) * (heights[i] - heights[i - 1]) /
+         (positions[i] - positions[i - 1]));
+      if (heights[i - 1] < h && h < heights[i + 1]) {
+        heights[i] = h;
+      }
+      else {
+        // Linear prediction
+        heights[i] += sign * (heights[i + sign] - heights[i]) /
+          (positions[i + sign] - positions[i]);
+      }
+      positions[i] += sign;
+    }
+  }
+}
+
+double P2Quantile::get() const
+{
+  if (count == 0) return std::numeric_limits<double>::quiet_NaN();
+  if (count <= 5) {
+    // Exact quantile (linear interpolation) on the few values available
+    std::vector<double> values(heights, heights + count);
+    std::sort(values.begin(), values.end());
+    double pos = p * (count - 1);
+    int low = (int)std::floor(pos);
+    int high = std::min(low + 1, count - 1);
+    return values[low] + (pos - low) * (values[high] - values[low]);
+  }
+  return heights[2];
+}
+
+MetricStats::MetricStats()
+  : count(0), mean(0), m2(0),
+    min(std::numeric_limits<double>::max()),
+    max(std::numeric_limits<double>::lowest())
+{
+  for (double p : getQuantileProbabilities()) {
+    quantiles.push_back(P2Quantile(p));
+  }
+}
+
+const std::vector<double> & MetricStats::getQuantileProbabilities()
+{
+  static const std::vector<double> probabilities = {0.05, 0.25, 0.5, 0.75, 0.95};
+  return probabilities;
+}
+
+void MetricStats::add(double value)
+{
+  count++;
+  double delta = value - mean;
+  mean += delta / count;
+  m2 += delta * (value - mean);
+  min = std::min(min, value);
+  max = std::max(max, value);
+  for (P2Quantile & quantile : quantiles) {
+    quantile.add(value);
+  }
+}
+
+int MetricStats::getCount() const { return count; }
+double MetricStats::getMean() const { return mean; }
+double MetricStats::getMin() const { return min; }
+double MetricStats::getMax() const { return max; }
+
+double MetricStats::getStdDev() const
+{
+  if (count < 2) return 0;
+  return std::sqrt(m2 / (count - 1));
+}
+
+double MetricStats::getCI() const
+{
+  if (count < 2) return 0;
+  return student975(count - 1) * getStdDev() / std::sqrt(count);
+}
+
+std::vector<double> MetricStats::getQuantiles() const
+{
+  std::vector<double> result;
+  for (const P2Quantile & quantile : quantiles) {
+    result.push_back(quantile.get());
+  }
+  return result;
+}
+
+ResultAggregator::ResultAggregator(const std::vector<std::string> & key_columns_,
+                                   const std::vector<std::string> & optional_key_columns,
+                                   const std::vector<std::string> & ignored_columns_)
+  : key_columns(key_columns_), nb_mandatory_keys(key_columns_.size()),
+    used_keys(key_columns_.size(), true), ignored_columns(ignored_columns_), nb_lines(0)
+{
+  if (key_columns.size() == 0) {
+    throw std::logic_error("ResultAggregator: at least one key column is required");
+  }
+  for (const std::string & column : optional_key_columns) {
+    key_columns.push_back(column);
+    used_keys.push_back(false);
+  }
+}
+
+int ResultAggregator::getMetricIndex(const std::string & name)
+{
+  auto it = metric_indices.find(name);
+  if (it != metric_indices.end()) return it->second;
+  int index = metric_names.size();
+  metric_names.push_back(name);
+  metric_indices[name] = index;
+  return index;
+}
+
+std::string ResultAggregator::keysHeader() const
+{
+  std::string header;
+  for (size_t i = 0; i < key_columns.size(); i++) {
+    if (used_keys[i]) header += key_columns[i] + ",";
+  }
+  return header;
+}
+
+std::string ResultAggregator::joinKey(const std::vector<std::string> & key) const
+{
+  std::string joined;
+  for (size_t i = 0; i < key.size(); i++) {
+    if (!used_keys[i]) continue;
+    // The first key column is mandatory, hence always used
+    if (i > 0) joined += ",";
+    joined += key[i];
+  }
+  return joined;
+}
+
+void ResultAggregator::addFile(const std::string & path)
+{
+  std::ifstream in(path);
+  if (!in.good()) {
+    throw std::runtime_error("ResultAggregator::addFile: failed to open '" + path + "'");
+  }
+  addStream(in);
+}
+
+void ResultAggregator::addStream(std::istream & in)
+{
+  std::string line;
+  std::vector<std::string> fields;
+  if (!std::getline(in, line)) return;
+  splitLine(line, fields);
+  // Identify key columns and metrics columns
+  std::vector<int> key_positions(key_columns.size(), -1);
+  std::vector<int> column_metrics(fields.size(), -1);
+  for (size_t col = 0; col < fields.size(); col++) {
+    auto it = std::find(key_columns.begin(), key_columns.end(), fields[col]);
+    if (it != key_columns.end()) {
+      key_positions[it - key_columns.begin()] = col;
+    }
+    else if (std::find(ignored_columns.begin(), ignored_columns.end(), fields[col])
+             == ignored_columns.end()) {
+      column_metrics[col] = getMetricIndex(fields[col]);
+    }
+  }
+  for (size_t i = 0; i < key_columns.size(); i++) {
+    if (key_positions[i] >= 0) {
+      used_keys[i] = true;
+    }
+    else if (i < nb_mandatory_keys) {
+      throw std::runtime_error("ResultAggregator: missing key column '" + key_columns[i] + "'");
+    }
+  }
+  // Streaming over the lines, optional keys missing in this file are empty
+  std::vector<std::string> key(key_columns.size());
+  while (std::getline(in, line)) {
+    if (line.empty()) continue;
+    splitLine(line, fields);
+    for (size_t i = 0; i < key_positions.size(); i++) {
+      if (key_positions[i] < 0) continue;
+      if (key_positions[i] >= (int)fields.size()) {
+        throw std::runtime_error("ResultAggregator: malformed line '" + line + "'");
+      }
+      key[i] = fields[key_positions[i]];
+    }
+    std::vector<MetricStats> & group = groups[key];
+    if (group.size() < metric_names.size()) group.resize(metric_names.size());
+    for (size_t col = 0; col < fields.size() && col < column_metrics.size(); col++) {
+      if (column_metrics[col] < 0) continue;
+      // Non numerical values are ignored
+      const char * str = fields[col].c_str();
+      char * end;
+      double value = std::strtod(str, &end);
+      if (end == str || !std::isfinite(value)) continue;
+      group[column_metrics[col]].add(value);
+    }
+    nb_lines++;
+  }
+}
+
+void ResultAggregator::writeSummary(const std::string & path) const
+{
+  std::ofstream out(path);
+  if (!out.good()) {
+    throw std::runtime_error("ResultAggregator::writeSummary: failed to open '" + path + "'");
+  }
+  out << keysHeader() << "metric,count,mean,sd,ci,min";
+  for (double p : MetricStats::getQuantileProbabilities()) {
+    out << ",q" << (int)std::round(100 * p);
+  }
+  out << ",max\n";
+  for (const auto & entry : groups) {
+    for (size_t metric = 0; metric < entry.second.size(); metric++) {
+      const MetricStats & stats = entry.second[metric];
+      if (stats.getCount() == 0) continue;
+      out << joinKey(entry.first) << "," << metric_names[metric] << ","
+          << stats.getCount() << "," << stats.getMean() << ","
+          << stats.getStdDev() << "," << stats.getCI() << "," << stats.getMin();
+      for (double q : stats.getQuantiles()) {
+        out << "," << q;
+      }
+      out << "," << stats.getMax() << "\n";
+    }
+  }
+}
+
+void ResultAggregator::writeParetoFront(const std::string & path,
+                                        const std::vector<std::pair<std::string, std::string>> & objectives) const
+{
+  std::ofstream out(path);
+  if (!out.good()) {
+    throw std::runtime_error("ResultAggregator::writeParetoFront: failed to open '" + path + "'");
+  }
+  out << keysHeader() << "accuracy_metric,cost_metric,accuracy,cost\n";
+  for (const auto & objective : objectives) {
+    auto accuracy_it = metric_indices.find(objective.first);
+    auto cost_it = metric_indices.find(objective.second);
+    if (accuracy_it == metric_indices.end() || cost_it == metric_indices.end()) continue;
+    int accuracy_metric = accuracy_it->second;
+    int cost_metric = cost_it->second;
+    // Partition: first key column -> [(cost, accuracy, key)]
+    struct Point { double cost; double accuracy; std::string key; };
+    std::map<std::string, std::vector<Point>> partitions;
+    for (const auto & entry : groups) {
+      if ((int)entry.second.size() <= std::max(accuracy_metric, cost_metric)) continue;
+      const MetricStats & accuracy = entry.second[accuracy_metric];
+      const MetricStats & cost = entry.second[cost_metric];
+      if (accuracy.getCount() == 0 || cost.getCount() == 0) continue;
+      partitions[entry.first[0]].push_back({cost.getMean(), accuracy.getMean(),
+                                            joinKey(entry.first)});
+    }
+    for (auto & partition : partitions) {
+      std::vector<Point> & points = partition.second;
+      // Sorting by cost then accuracy: a point is on the front if it is more
+      // accurate than all the cheaper points
+      std::sort(points.begin(), points.end(), [](const Point & a, const Point & b)
+                {
+                  if (a.cost != b.cost) return a.cost < b.cost;
+                  return a.accuracy < b.accuracy;
+                });
+      double best_accuracy = std::numeric_limits<double>::max();
+      for (const Point & point : points) {
+        if (point.accuracy >= best_accuracy) continue;
+        best_accuracy = point.accuracy;
+        out << point.key << "," << objective.first << "," << objective.second << ","
+            << point.accuracy << "," << point.cost << "\n";
+      }
+    }
+  }
+}
+
+long ResultAggregator::getNbLines() const
+{
+  return nb_lines;
+}
+
+}
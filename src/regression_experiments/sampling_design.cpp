@@ -0,0 +1,38 @@
+#include "regression_experiments/sampling_design.h"
+
+namespace regression_experiments
+{
+
+void SamplingDesign::to_xml(std::ostream &out) const
+{
+  (void) out;
+}
+
+void SamplingDesign::from_xml(TiXmlNode *node)
+{
+  (void) node;
+}
+
+void SamplingDesign::scaleToLimits(const Eigen::MatrixXd & limits, Eigen::MatrixXd & points)
+{
+  Eigen::VectorXd low = limits.col(0);
+  Eigen::VectorXd delta = limits.col(1) - limits.col(0);
+  for (int sample = 0; sample < points.cols(); sample++) {
+    points.col(sample) = low + delta.cwiseProduct(points.col(sample));
+  }
+}
+
+Eigen::MatrixXd UniformDesign::getSamples(const Eigen::MatrixXd & limits,
+                                          int nb_samples,
+                                          const RandomStream & stream,
+                                          int nb_threads) const
+{
+  return stream.uniformSamples(limits, nb_samples, nb_threads);
+}
+
+std::string UniformDesign::class_name() const
+{
+  return "uniform";
+}
+
+}
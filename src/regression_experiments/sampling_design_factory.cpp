@@ -0,0 +1,17 @@
+#include "regression_experiments/sampling_design_factory.h"
+#include "regression_experiments/space_filling_designs.h"
+
+namespace regression_experiments
+{
+
+SamplingDesignFactory::SamplingDesignFactory()
+{
+  registerBuilder("uniform"    , [](){return std::unique_ptr<SamplingDesign>(new UniformDesign);       });
+  registerBuilder("sobol"      , [](){return std::unique_ptr<SamplingDesign>(new SobolDesign);         });
+  registerBuilder("halton"     , [](){return std::unique_ptr<SamplingDesign>(new HaltonDesign);        });
+  registerBuilder("lhs"        , [](){return std::unique_ptr<SamplingDesign>(new LatinHypercubeDesign);});
+  registerBuilder("maximin_lhs",
+                  [](){return std::unique_ptr<SamplingDesign>(new MaximinLatinHypercubeDesign);});
+}
+
+}
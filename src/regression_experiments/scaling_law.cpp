@@ -0,0 +1,143 @@
+#include "regression_experiments/scaling_law.h"
+
+#include <Eigen/Dense>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <set>
+#include <stdexcept>
+
+namespace regression_experiments
+{
+
+/// Quantile 0.975 of the Student distribution with 'df' degrees of freedom
+static double studentQuantile(int df)
+{
+  static const double table[30] = {
+    12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+    2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+    2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+  };
+  if (df < 1) return std::numeric_limits<double>::quiet_NaN();
+  if (df <= 30) return table[df - 1];
+  // Cornish-Fisher expansion around the normal quantile
+  double z = 1.959964;
+  double z3 = z * z * z;
+  double z5 = z3 * z * z;
+  return z + (z3 + z) / (4 * df) + (5 * z5 + 16 * z3 + 3 * z) / (96.0 * df * df);
+}
+
+ScalingLaw::ScalingLaw()
+  : coefficient(-1), samples_exponent(0),
+    samples_low(std::numeric_limits<double>::quiet_NaN()),
+    samples_high(std::numeric_limits<double>::quiet_NaN()),
+    dimensions_exponent(0),
+    dimensions_low(std::numeric_limits<double>::quiet_NaN()),
+    dimensions_high(std::numeric_limits<double>::quiet_NaN()),
+    r2(std::numeric_limits<double>::quiet_NaN()), nb_observations(0)
+{}
+
+double ScalingLaw::predict(double nb_samples, double nb_dimensions) const
+{
+  return coefficient * std::pow(nb_samples, samples_exponent)
+    * std::pow(nb_dimensions, dimensions_exponent);
+}
+
+double ScalingLaw::maxSamples(double budget, double nb_dimensions) const
+{
+  if (samples_exponent <= 0) return std::numeric_limits<double>::infinity();
+  double base = coefficient * std::pow(nb_dimensions, dimensions_exponent);
+  return std::pow(budget / base, 1 / samples_exponent);
+}
+
+std::string ScalingLaw::csvHeader()
+{
+  return "nb_observations,coefficient,"
+    "samples_exponent,samples_low,samples_high,"
+    "dimensions_exponent,dimensions_low,dimensions_high,r2";
+}
+
+void ScalingLaw::writeCsv(std::ostream & out) const
+{
+  out << nb_observations << ","
+      << coefficient << ","
+      << samples_exponent << ","
+      << samples_low << ","
+      << samples_high << ","
+      << dimensions_exponent << ","
+      << dimensions_low << ","
+      << dimensions_high << ","
+      << r2;
+}
+
+ScalingLaw fitScalingLaw(const std::vector<ScalingObservation> & observations,
+                         double min_value)
+{
+  if (observations.empty()) {
+    throw std::logic_error("fitScalingLaw: no observations");
+  }
+  std::set<double> samples, dimensions;
+  for (const ScalingObservation & observation : observations) {
+    samples.insert(observation.nb_samples);
+    dimensions.insert(observation.nb_dimensions);
+  }
+  int nb_obs = observations.size();
+  Eigen::VectorXd y(nb_obs);
+  Eigen::VectorXd log_samples(nb_obs), log_dimensions(nb_obs);
+  for (int i = 0; i < nb_obs; i++) {
+    y(i) = std::log(std::max(observations[i].value, min_value));
+    log_samples(i) = std::log(observations[i].nb_samples);
+    log_dimensions(i) = std::log(observations[i].nb_dimensions);
+  }
+  // Only the factors which vary are part of the regression, the dimension
+  // factor is also dropped if it cannot be separated from the samples one
+  // (e.g. a single number of samples reached for each dimension)
+  bool use_samples = samples.size() > 1;
+  bool use_dimensions = dimensions.size() > 1;
+  Eigen::MatrixXd X;
+  Eigen::ColPivHouseholderQR<Eigen::MatrixXd> qr;
+  while (true) {
+    int nb_params = 1 + (use_samples ? 1 : 0) + (use_dimensions ? 1 : 0);
+    X = Eigen::MatrixXd::Ones(nb_obs, nb_params);
+    int col = 1;
+    if (use_samples) X.col(col++) = log_samples;
+    if (use_dimensions) X.col(col++) = log_dimensions;
+    qr.compute(X);
+    if (qr.rank() == nb_params || !use_dimensions) break;
+    use_dimensions = false;
+  }
+  Eigen::VectorXd params = qr.solve(y);
+  Eigen::VectorXd residuals = y - X * params;
+  int df = nb_obs - X.cols();
+  double rss = residuals.squaredNorm();
+  double tss = (y.array() - y.mean()).square().sum();
+
+  ScalingLaw law;
+  law.nb_observations = nb_obs;
+  law.coefficient = std::exp(params(0));
+  law.r2 = tss > 0 ? 1 - rss / tss : 1;
+  // Standard errors from the covariance of the least squares estimator
+  Eigen::VectorXd std_errors = Eigen::VectorXd::Constant(X.cols(),
+                                                         std::numeric_limits<double>::quiet_NaN());
+  if (df > 0) {
+    Eigen::MatrixXd covariance = (X.transpose() * X).inverse() * (rss / df);
+    std_errors = covariance.diagonal().cwiseSqrt();
+  }
+  double t = studentQuantile(df);
+  int col = 1;
+  if (use_samples) {
+    law.samples_exponent = params(col);
+    law.samples_low = params(col) - t * std_errors(col);
+    law.samples_high = params(col) + t * std_errors(col);
+    col++;
+  }
+  if (use_dimensions) {
+    law.dimensions_exponent = params(col);
+    law.dimensions_low = params(col) - t * std_errors(col);
+    law.dimensions_high = params(col) + t * std_errors(col);
+  }
+  return law;
+}
+
+}
@@ -0,0 +1,102 @@
+#include "regression_experiments/sequential_design.h"
+
+#include "regression_experiments/trace_recorder.h"
+
+#include "rosban_utils/time_stamp.h"
+
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+
+using rosban_fa::FunctionApproximator;
+using rosban_fa::Trainer;
+using rosban_utils::TimeStamp;
+
+namespace regression_experiments
+{
+
+std::vector<SequentialIteration>
+runSequentialDesign(std::shared_ptr<const BenchmarkFunction> function,
+                    std::shared_ptr<const Trainer> trainer,
+                    int nb_initial_samples,
+                    int nb_iterations,
+                    const RandomStream & stream,
+                    int nb_threads)
+{
+  Eigen::MatrixXd limits = function->getLimits();
+  // Regret and loss are reported as -1 if the maximum is unknown
+  bool known_max = true;
+  double max_value = 0;
+  try{
+    max_value = function->getMax();
+  }
+  catch(const std::runtime_error & exc) {
+    known_max = false;
+    std::cerr << exc.what() << std::endl;
+  }
+  double noise = function->getObservationNoise();
+  // Initial samples, noise-free values are kept to compute the regret
+  RandomStream training_stream = stream.withPurpose(RandomPurpose::TrainingSamples);
+  Eigen::MatrixXd inputs;
+  Eigen::VectorXd values;
+  function->getUniformSamples(nb_initial_samples, inputs, values, training_stream, false, nb_threads);
+  Eigen::VectorXd observations = values;
+  if (noise > 0) {
+    observations += noise * training_stream.withSubstream(1).gaussian(nb_initial_samples, nb_threads);
+  }
+  double best_value = nb_initial_samples > 0 ? values.maxCoeff()
+                                             : -std::numeric_limits<double>::infinity();
+  RandomStream sequential_stream = stream.withPurpose(RandomPurpose::SequentialDesign);
+
+  std::vector<SequentialIteration> iterations;
+  std::shared_ptr<const FunctionApproximator> fa;
+  TimeStamp loop_start = TimeStamp::now();
+  for (int iteration = 0; iteration < nb_iterations; iteration++) {
+    SequentialIteration result;
+    result.iteration = iteration;
+    result.nb_samples = inputs.cols();
+    // Fit
+    TimeStamp fit_start = TimeStamp::now();
+    {
+      TraceScope trace("fit", "phase");
+      fa = trainer->train(inputs, observations, limits);
+    }
+    TimeStamp search_start = TimeStamp::now();
+    result.fit_time = diffSec(fit_start, search_start);
+    // Max search
+    Eigen::VectorXd best_input;
+    {
+      TraceScope trace("compute_max", "phase");
+      fa->getMaximum(limits, best_input, result.expected_max);
+    }
+    TimeStamp evaluation_start = TimeStamp::now();
+    result.max_search_time = diffSec(search_start, evaluation_start);
+    // Sampling at the proposed input
+    double value;
+    {
+      TraceScope trace("evaluation", "phase");
+      value = function->sample(best_input);
+    }
+    TimeStamp evaluation_end = TimeStamp::now();
+    result.evaluation_time = diffSec(evaluation_start, evaluation_end);
+    result.cumulative_time = diffSec(loop_start, evaluation_end);
+    double observation = value;
+    if (noise > 0) {
+      double gaussian;
+      sequential_stream.gaussian(iteration, 1, &gaussian);
+      observation += noise * gaussian;
+    }
+    int nb_samples = inputs.cols();
+    inputs.conservativeResize(inputs.rows(), nb_samples + 1);
+    inputs.col(nb_samples) = best_input;
+    observations.conservativeResize(nb_samples + 1);
+    observations(nb_samples) = observation;
+    best_value = std::max(best_value, value);
+    result.arg_max_loss = known_max ? max_value - value : -1;
+    result.simple_regret = known_max ? max_value - best_value : -1;
+    iterations.push_back(result);
+  }
+  return iterations;
+}
+
+}
@@ -1,6 +1,27 @@
 set(SOURCES
+  adaptive_grid.cpp
+  anytime_profile.cpp
   basic_functions.cpp
   benchmark_function.cpp
   benchmark_function_factory.cpp
+  counter_rng.cpp
+  evaluation_pool.cpp
+  expensive_function.cpp
+  memory_usage.cpp
+  parallel.cpp
+  perf_counters.cpp
+  placement.cpp
+  prediction_exporter.cpp
+  progress_monitor.cpp
+  random_function.cpp
+  result_aggregator.cpp
+  sampling_design.cpp
+  sampling_design_factory.cpp
+  scaling_law.cpp
+  sequential_design.cpp
+  space_filling_designs.cpp
+  timing.cpp
   tools.cpp
+  trace_recorder.cpp
+  tuning.cpp
 )
\ No newline at end of file
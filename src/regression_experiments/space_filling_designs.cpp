@@ -0,0 +1,436 @@
+#include "regression_experiments/space_filling_designs.h"
+
+#include "regression_experiments/parallel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <mutex>
+#include <sstream>
+
+namespace regression_experiments
+{
+
+/// Primitive polynomials and initial direction numbers for dimensions 2 to 21
+/// of the Sobol sequence (Joe & Kuo, new-joe-kuo-6.21201)
+struct SobolEntry
+{
+  /// Degree of the polynomial
+  int s;
+  /// Coefficients of the polynomial
+  uint32_t a;
+  /// Initial direction numbers
+  uint32_t m[7];
+};
+
+static const SobolEntry sobol_table[] = {
+  {1,  0, {1}},
+  {2,  1, {1, 3}},
+  {3,  1, {1, 3, 1}},
+  {3,  2, {1, 1, 1}},
+  {4,  1, {1, 1, 3, 3}},
+  {4,  4, {1, 3, 5, 13}},
+  {5,  2, {1, 1, 5, 5, 17}},
+  {5,  4, {1, 1, 5, 5, 5}},
+  {5,  7, {1, 1, 7, 11, 19}},
+  {5, 11, {1, 1, 5, 1, 1}},
+  {5, 13, {1, 1, 1, 3, 11}},
+  {5, 14, {1, 3, 5, 5, 31}},
+  {6,  1, {1, 3, 3, 9, 7, 49}},
+  {6, 13, {1, 1, 1, 15, 21, 21}},
+  {6, 16, {1, 3, 1, 13, 27, 49}},
+  {6, 19, {1, 1, 1, 15, 7, 5}},
+  {6, 22, {1, 3, 1, 15, 13, 25}},
+  {6, 25, {1, 1, 5, 5, 19, 61}},
+  {7,  1, {1, 3, 7, 11, 23, 15, 103}},
+  {7,  4, {1, 3, 7, 13, 13, 15, 69}}
+};
+
+static const int sobol_bits = 32;
+
+/// Fill the direction numbers of the given dimension (starting at 0)
+static void getSobolDirections(int dim, uint32_t * directions)
+{
+  if (dim == 0) {
+    for (int k = 0; k < sobol_bits; k++) {
+      directions[k] = 1u << (31 - k);
+    }
+    return;
+  }
+  const SobolEntry & entry = sobol_table[dim - 1];
+  int s = entry.s;
+  for (int k = 0; k < sobol_bits; k++) {
+    if (k < s) {
+      directions[k] = entry.m[k] << (31 - k);
+      continue;
+    }
+    directions[k] = directions[k - s] ^ (directions[k - s] >> s);
+    for (int j = 1; j < s; j++) {
+      if ((entry.a >> (s - 1 - j)) & 1) {
+        directions[k] ^= directions[k - j];
+      }
+    }
+  }
+}
+
+/// Multiply the digits of 'value' (most significant first) by a lower
+/// triangular binary matrix given by its rows
+static uint32_t applyLinearScramble(const uint32_t * rows, uint32_t value)
+{
+  uint32_t result = 0;
+  for (int r = 0; r < sobol_bits; r++) {
+    result |= (uint32_t)__builtin_parity(rows[r] & value) << (31 - r);
+  }
+  return result;
+}
+
+SobolDesign::SobolDesign()
+  : scrambled(true)
+{}
+
+int SobolDesign::getMaxDimensions()
+{
+  return 1 + sizeof(sobol_table) / sizeof(SobolEntry);
+}
+
+Eigen::MatrixXd SobolDesign::getSamples(const Eigen::MatrixXd & limits,
+                                        int nb_samples,
+                                        const RandomStream & stream,
+                                        int nb_threads) const
+{
+  int dims = limits.rows();
+  if (dims > getMaxDimensions()) {
+    std::ostringstream oss;
+    oss << "SobolDesign::getSamples: " << dims << " dimensions requested, "
+        << getMaxDimensions() << " supported";
+    throw std::runtime_error(oss.str());
+  }
+  // Direction numbers and shift of each dimension
+  std::vector<uint32_t> directions(dims * sobol_bits);
+  std::vector<uint32_t> shifts(dims, 0);
+  for (int dim = 0; dim < dims; dim++) {
+    uint32_t * dim_directions = directions.data() + dim * sobol_bits;
+    getSobolDirections(dim, dim_directions);
+    if (!scrambled) continue;
+    // Random lower triangular matrix with unit diagonal and random shift
+    uint32_t words[sobol_bits + 1];
+    stream.bits(dim * (sobol_bits + 1), sobol_bits + 1, words);
+    uint32_t rows[sobol_bits];
+    for (int r = 0; r < sobol_bits; r++) {
+      uint32_t above_diagonal = r == 0 ? 0 : ~((1u << (32 - r)) - 1);
+      rows[r] = (1u << (31 - r)) | (words[r] & above_diagonal);
+    }
+    for (int k = 0; k < sobol_bits; k++) {
+      dim_directions[k] = applyLinearScramble(rows, dim_directions[k]);
+    }
+    shifts[dim] = words[sobol_bits];
+  }
+  // Computing points directly from their index (gray code order)
+  Eigen::MatrixXd samples(dims, nb_samples);
+  runParallel(nb_samples, nb_threads, [&](int start, int end)
+              {
+                for (int sample = start; sample < end; sample++) {
+                  uint32_t gray = (uint32_t)sample ^ ((uint32_t)sample >> 1);
+                  for (int dim = 0; dim < dims; dim++) {
+                    const uint32_t * dim_directions = directions.data() + dim * sobol_bits;
+                    uint32_t value = shifts[dim];
+                    for (int k = 0; gray >> k; k++) {
+                      if ((gray >> k) & 1) value ^= dim_directions[k];
+                    }
+                    samples(dim, sample) = (value + 0.5) / 4294967296.0;
+                  }
+                }
+              });
+  scaleToLimits(limits, samples);
+  return samples;
+}
+
+std::string SobolDesign::class_name() const
+{
+  return "sobol";
+}
+
+void SobolDesign::to_xml(std::ostream &out) const
+{
+  rosban_utils::xml_tools::write<bool>("scrambled", scrambled, out);
+}
+
+void SobolDesign::from_xml(TiXmlNode *node)
+{
+  rosban_utils::xml_tools::try_read<bool>(node, "scrambled", scrambled);
+}
+
+static const int halton_primes[] = {
+    2,   3,   5,   7,  11,  13,  17,  19,  23,  29,  31,  37,  41,  43,  47,  53,
+   59,  61,  67,  71,  73,  79,  83,  89,  97, 101, 103, 107, 109, 113, 127, 131
+};
+
+HaltonDesign::HaltonDesign()
+  : scrambled(true)
+{}
+
+int HaltonDesign::getMaxDimensions()
+{
+  return sizeof(halton_primes) / sizeof(int);
+}
+
+Eigen::MatrixXd HaltonDesign::getSamples(const Eigen::MatrixXd & limits,
+                                         int nb_samples,
+                                         const RandomStream & stream,
+                                         int nb_threads) const
+{
+  int dims = limits.rows();
+  if (dims > getMaxDimensions()) {
+    std::ostringstream oss;
+    oss << "HaltonDesign::getSamples: " << dims << " dimensions requested, "
+        << getMaxDimensions() << " supported";
+    throw std::runtime_error(oss.str());
+  }
+  // permutations[dim][digit][value]
+  std::vector<std::vector<std::vector<int>>> permutations(dims);
+  uint64_t offset = 0;
+  for (int dim = 0; dim < dims; dim++) {
+    int base = halton_primes[dim];
+    // Enough digits to reach the double precision
+    int nb_digits = (int)std::ceil(52 / std::log2(base));
+    permutations[dim].resize(nb_digits);
+    for (int digit = 0; digit < nb_digits; digit++) {
+      std::vector<int> & permutation = permutations[dim][digit];
+      permutation.resize(base);
+      for (int value = 0; value < base; value++) permutation[value] = value;
+      if (!scrambled) continue;
+      // Fisher-Yates shuffle
+      std::vector<double> uniforms(base);
+      stream.uniform(offset, base, uniforms.data());
+      offset += base;
+      for (int i = base - 1; i > 0; i--) {
+        int j = std::min(i, (int)(uniforms[i] * (i + 1)));
+        std::swap(permutation[i], permutation[j]);
+      }
+    }
+  }
+  Eigen::MatrixXd samples(dims, nb_samples);
+  runParallel(nb_samples, nb_threads, [&](int start, int end)
+              {
+                for (int sample = start; sample < end; sample++) {
+                  for (int dim = 0; dim < dims; dim++) {
+                    int base = halton_primes[dim];
+                    const std::vector<std::vector<int>> & dim_permutations = permutations[dim];
+                    // Radical inverse with permuted digits
+                    double value = 0;
+                    double factor = 1.0 / base;
+                    unsigned int index = sample;
+                    for (size_t digit = 0; digit < dim_permutations.size(); digit++) {
+                      value += dim_permutations[digit][index % base] * factor;
+                      index /= base;
+                      factor /= base;
+                      if (index == 0 && !scrambled) break;
+                    }
+                    samples(dim, sample) = value;
+                  }
+                }
+              });
+  scaleToLimits(limits, samples);
+  return samples;
+}
+
+std::string HaltonDesign::class_name() const
+{
+  return "halton";
+}
+
+void HaltonDesign::to_xml(std::ostream &out) const
+{
+  rosban_utils::xml_tools::write<bool>("scrambled", scrambled, out);
+}
+
+void HaltonDesign::from_xml(TiXmlNode *node)
+{
+  rosban_utils::xml_tools::try_read<bool>(node, "scrambled", scrambled);
+}
+
+Eigen::MatrixXd LatinHypercubeDesign::getUnitSamples(int dims, int nb_samples,
+                                                     const RandomStream & stream,
+                                                     uint64_t offset,
+                                                     int nb_threads)
+{
+  Eigen::MatrixXd samples(dims, nb_samples);
+  // Dimensions are independent
+  runParallel(dims, nb_threads, [&](int start, int end)
+              {
+                std::vector<int> permutation(nb_samples);
+                std::vector<double> uniforms(2 * nb_samples);
+                for (int dim = start; dim < end; dim++) {
+                  uint64_t dim_offset = offset + (uint64_t)dim * 2 * nb_samples;
+                  stream.uniform(dim_offset, 2 * nb_samples, uniforms.data());
+                  for (int i = 0; i < nb_samples; i++) permutation[i] = i;
+                  for (int i = nb_samples - 1; i > 0; i--) {
+                    int j = std::min(i, (int)(uniforms[i] * (i + 1)));
+                    std::swap(permutation[i], permutation[j]);
+                  }
+                  for (int i = 0; i < nb_samples; i++) {
+                    // uniforms are in ]0,1]
+                    double jitter = 1 - uniforms[nb_samples + i];
+                    samples(dim, i) = (permutation[i] + jitter) / nb_samples;
+                  }
+                }
+              });
+  return samples;
+}
+
+Eigen::MatrixXd LatinHypercubeDesign::getSamples(const Eigen::MatrixXd & limits,
+                                                 int nb_samples,
+                                                 const RandomStream & stream,
+                                                 int nb_threads) const
+{
+  Eigen::MatrixXd samples = getUnitSamples(limits.rows(), nb_samples, stream, 0, nb_threads);
+  scaleToLimits(limits, samples);
+  return samples;
+}
+
+std::string LatinHypercubeDesign::class_name() const
+{
+  return "lhs";
+}
+
+MaximinLatinHypercubeDesign::MaximinLatinHypercubeDesign()
+  : nb_candidates(10)
+{}
+
+double MaximinLatinHypercubeDesign::getMinDistance(const Eigen::MatrixXd & points,
+                                                   int nb_threads)
+{
+  int dims = points.rows();
+  int nb_points = points.cols();
+  if (nb_points < 2) return std::numeric_limits<double>::infinity();
+  std::mutex mutex;
+  double min_dist2 = std::numeric_limits<double>::max();
+  double nb_neighbour_cells = std::pow(3.0, dims);
+  // Small sets: all pairs are compared
+  if (nb_points <= 4096 || 2 * nb_neighbour_cells > nb_points) {
+    runParallel(nb_points, nb_threads, [&](int start, int end)
+                {
+                  double local_min = std::numeric_limits<double>::max();
+                  for (int i = start; i < end; i++) {
+                    for (int j = i + 1; j < nb_points; j++) {
+                      local_min = std::min(local_min, (points.col(i) - points.col(j)).squaredNorm());
+                    }
+                  }
+                  std::lock_guard<std::mutex> lock(mutex);
+                  min_dist2 = std::min(min_dist2, local_min);
+                });
+    return std::sqrt(min_dist2);
+  }
+  // Regular grid with less cells than half the number of points
+  int cells_per_dim = std::max(1, (int)std::floor(std::pow(nb_points / 2.0, 1.0 / dims)));
+  Eigen::VectorXd low = points.rowwise().minCoeff();
+  Eigen::VectorXd cell_size = (points.rowwise().maxCoeff() - low) / cells_per_dim;
+  int nb_cells = 1;
+  for (int dim = 0; dim < dims; dim++) nb_cells *= cells_per_dim;
+  auto getCellCoordinate = [&](int point, int dim)
+    {
+      if (cell_size(dim) <= 0) return 0;
+      int coordinate = (int)((points(dim, point) - low(dim)) / cell_size(dim));
+      return std::min(coordinate, cells_per_dim - 1);
+    };
+  // Counting sort of the points by cell
+  std::vector<int> point_cells(nb_points);
+  std::vector<int> cell_starts(nb_cells + 1, 0);
+  for (int point = 0; point < nb_points; point++) {
+    int cell = 0;
+    for (int dim = dims - 1; dim >= 0; dim--) {
+      cell = cell * cells_per_dim + getCellCoordinate(point, dim);
+    }
+    point_cells[point] = cell;
+    cell_starts[cell + 1]++;
+  }
+  for (int cell = 0; cell < nb_cells; cell++) cell_starts[cell + 1] += cell_starts[cell];
+  std::vector<int> sorted_points(nb_points);
+  std::vector<int> fill(cell_starts.begin(), cell_starts.end() - 1);
+  for (int point = 0; point < nb_points; point++) {
+    sorted_points[fill[point_cells[point]]++] = point;
+  }
+  // Each point is compared to the points of the neighbouring cells
+  runParallel(nb_points, nb_threads, [&](int start, int end)
+              {
+                double local_min = std::numeric_limits<double>::max();
+                std::vector<int> coordinates(dims), offsets(dims);
+                for (int point = start; point < end; point++) {
+                  for (int dim = 0; dim < dims; dim++) {
+                    coordinates[dim] = getCellCoordinate(point, dim);
+                    offsets[dim] = -1;
+                  }
+                  while (true) {
+                    // Index of the neighbour cell
+                    int cell = 0;
+                    bool valid = true;
+                    for (int dim = dims - 1; dim >= 0; dim--) {
+                      int coordinate = coordinates[dim] + offsets[dim];
+                      if (coordinate < 0 || coordinate >= cells_per_dim) valid = false;
+                      cell = cell * cells_per_dim + coordinate;
+                    }
+                    if (valid) {
+                      for (int i = cell_starts[cell]; i < cell_starts[cell + 1]; i++) {
+                        int other = sorted_points[i];
+                        if (other <= point) continue;
+                        local_min = std::min(local_min,
+                                             (points.col(point) - points.col(other)).squaredNorm());
+                      }
+                    }
+                    // Next offset in {-1,0,1}^dims
+                    int dim = 0;
+                    while (dim < dims && offsets[dim] == 1) {
+                      offsets[dim] = -1;
+                      dim++;
+                    }
+                    if (dim == dims) break;
+                    offsets[dim]++;
+                  }
+                }
+                std::lock_guard<std::mutex> lock(mutex);
+                min_dist2 = std::min(min_dist2, local_min);
+              });
+  return std::sqrt(min_dist2);
+}
+
+Eigen::MatrixXd MaximinLatinHypercubeDesign::getSamples(const Eigen::MatrixXd & limits,
+                                                        int nb_samples,
+                                                        const RandomStream & stream,
+                                                        int nb_threads) const
+{
+  int dims = limits.rows();
+  Eigen::MatrixXd best;
+  double best_distance = -1;
+  for (int candidate = 0; candidate < nb_candidates; candidate++) {
+    uint64_t offset = (uint64_t)candidate * 2 * nb_samples * dims;
+    Eigen::MatrixXd samples;
+    samples = LatinHypercubeDesign::getUnitSamples(dims, nb_samples, stream, offset, nb_threads);
+    double distance = getMinDistance(samples, nb_threads);
+    if (distance > best_distance) {
+      best_distance = distance;
+      best = samples;
+    }
+  }
+  scaleToLimits(limits, best);
+  return best;
+}
+
+std::string MaximinLatinHypercubeDesign::class_name() const
+{
+  return "maximin_lhs";
+}
+
+void MaximinLatinHypercubeDesign::to_xml(std::ostream &out) const
+{
+  rosban_utils::xml_tools::write<int>("nb_candidates", nb_candidates, out);
+}
+
+void MaximinLatinHypercubeDesign::from_xml(TiXmlNode *node)
+{
+  rosban_utils::xml_tools::try_read<int>(node, "nb_candidates", nb_candidates);
+  if (nb_candidates < 1) {
+    throw std::runtime_error("MaximinLatinHypercubeDesign: nb_candidates should be at least 1");
+  }
+}
+
+}
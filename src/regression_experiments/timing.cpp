@@ -0,0 +1,263 @@
+#include "regression_experiments/timing.h"
+
+#include "regression_experiments/placement.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+
+#include <sched.h>
+
+namespace regression_experiments
+{
+
+TimingOptions::TimingOptions()
+  : nb_warmup(1), min_repetitions(5), max_repetitions(50), target_precision(0.02),
+    outlier_threshold(3), max_time(60)
+{}
+
+std::string TimingOptions::class_name() const
+{
+  return "timing";
+}
+
+void TimingOptions::to_xml(std::ostream &out) const
+{
+  rosban_utils::xml_tools::write<int>   ("nb_warmup"        , nb_warmup        , out);
+  rosban_utils::xml_tools::write<int>   ("min_repetitions"  , min_repetitions  , out);
+  rosban_utils::xml_tools::write<int>   ("max_repetitions"  , max_repetitions  , out);
+  rosban_utils::xml_tools::write<double>("target_precision" , target_precision , out);
+  rosban_utils::xml_tools::write<double>("outlier_threshold", outlier_threshold, out);
+  rosban_utils::xml_tools::write<double>("max_time"         , max_time         , out);
+}
+
+void TimingOptions::from_xml(TiXmlNode *node)
+{
+  rosban_utils::xml_tools::try_read<int>   (node, "nb_warmup"        , nb_warmup        );
+  rosban_utils::xml_tools::try_read<int>   (node, "min_repetitions"  , min_repetitions  );
+  rosban_utils::xml_tools::try_read<int>   (node, "max_repetitions"  , max_repetitions  );
+  rosban_utils::xml_tools::try_read<double>(node, "target_precision" , target_precision );
+  rosban_utils::xml_tools::try_read<double>(node, "outlier_threshold", outlier_threshold);
+  rosban_utils::xml_tools::try_read<double>(node, "max_time"         , max_time         );
+  if (nb_warmup < 0 || min_repetitions < 1 || max_repetitions < min_repetitions) {
+    throw std::runtime_error("TimingOptions: invalid number of runs");
+  }
+}
+
+MachineState::MachineState()
+  : min_frequency(-1), max_frequency(-1), governor("unknown"), load_average(-1),
+    current_cpu(-1)
+{}
+
+/// Current frequency of each cpu [MHz] from cpufreq, or from /proc/cpuinfo
+/// when cpufreq is not available (e.g. virtual machines)
+static std::map<int, double> readFrequencies(const std::vector<int> & cpus)
+{
+  std::map<int, double> frequencies;
+  for (int cpu : cpus) {
+    std::ifstream in("/sys/devices/system/cpu/cpu" + std::to_string(cpu)
+                     + "/cpufreq/scaling_cur_freq");
+    double khz;
+    if (in >> khz) frequencies[cpu] = khz / 1000;
+  }
+  if (!frequencies.empty()) return frequencies;
+  std::ifstream cpuinfo("/proc/cpuinfo");
+  std::string line;
+  int processor = -1;
+  while (std::getline(cpuinfo, line)) {
+    size_t separator = line.find(':');
+    if (separator == std::string::npos) continue;
+    std::string key = line.substr(0, line.find_last_not_of(" \t", separator - 1) + 1);
+    std::string value = line.substr(separator + 1);
+    if (key == "processor") {
+      processor = std::atoi(value.c_str());
+    }
+    else if (key == "cpu MHz" &&
+             std::find(cpus.begin(), cpus.end(), processor) != cpus.end()) {
+      frequencies[processor] = std::atof(value.c_str());
+    }
+  }
+  return frequencies;
+}
+
+MachineState MachineState::capture()
+{
+  MachineState state;
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  std::vector<int> cpus;
+  if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+      if (CPU_ISSET(cpu, &set)) cpus.push_back(cpu);
+    }
+  }
+  state.allowed_cpus = cpusToString(cpus);
+  state.current_cpu = sched_getcpu();
+  for (const auto & entry : readFrequencies(cpus)) {
+    if (state.min_frequency < 0 || entry.second < state.min_frequency) {
+      state.min_frequency = entry.second;
+    }
+    state.max_frequency = std::max(state.max_frequency, entry.second);
+  }
+  if (state.current_cpu >= 0) {
+    std::ifstream in("/sys/devices/system/cpu/cpu" + std::to_string(state.current_cpu)
+                     + "/cpufreq/scaling_governor");
+    std::string governor;
+    if (in >> governor) state.governor = governor;
+  }
+  double load[1];
+  if (getloadavg(load, 1) == 1) state.load_average = load[0];
+  return state;
+}
+
+MachineState MachineState::merge(const std::vector<MachineState> & states)
+{
+  if (states.empty()) return MachineState();
+  MachineState merged = states.back();
+  for (const MachineState & state : states) {
+    if (state.min_frequency >= 0 &&
+        (merged.min_frequency < 0 || state.min_frequency < merged.min_frequency)) {
+      merged.min_frequency = state.min_frequency;
+    }
+    merged.max_frequency = std::max(merged.max_frequency, state.max_frequency);
+    merged.load_average = std::max(merged.load_average, state.load_average);
+    if (state.governor != merged.governor) merged.governor = "mixed";
+    if (state.allowed_cpus != merged.allowed_cpus) merged.allowed_cpus = "mixed";
+    if (state.current_cpu != merged.current_cpu) merged.current_cpu = -1;
+  }
+  return merged;
+}
+
+std::string MachineState::csvHeader(const std::string & prefix)
+{
+  std::ostringstream oss;
+  oss << prefix << "min_frequency,"
+      << prefix << "max_frequency,"
+      << prefix << "governor,"
+      << prefix << "load_average,"
+      << prefix << "allowed_cpus,"
+      << prefix << "current_cpu";
+  return oss.str();
+}
+
+void MachineState::writeCsv(std::ostream & out) const
+{
+  out << min_frequency << ","
+      << max_frequency << ","
+      << governor << ","
+      << load_average << ","
+      << "\"" << allowed_cpus << "\","
+      << current_cpu;
+}
+
+TimingSummary::TimingSummary()
+  : median(-1), ci_low(-1), ci_high(-1), nb_measures(0), nb_outliers(0), nb_warmup(0),
+    stable(false)
+{}
+
+std::string TimingSummary::csvHeader(const std::string & prefix)
+{
+  std::ostringstream oss;
+  oss << prefix << "median,"
+      << prefix << "ci_low,"
+      << prefix << "ci_high,"
+      << prefix << "nb_measures,"
+      << prefix << "nb_outliers,"
+      << prefix << "nb_warmup,"
+      << prefix << "stable,"
+      << MachineState::csvHeader(prefix);
+  return oss.str();
+}
+
+void TimingSummary::writeCsv(std::ostream & out) const
+{
+  out << median << ","
+      << ci_low << ","
+      << ci_high << ","
+      << nb_measures << ","
+      << nb_outliers << ","
+      << nb_warmup << ","
+      << stable << ",";
+  machine.writeCsv(out);
+}
+
+/// Median of sorted values
+static double sortedMedian(const std::vector<double> & values)
+{
+  size_t n = values.size();
+  if (n % 2 == 1) return values[n / 2];
+  return (values[n / 2 - 1] + values[n / 2]) / 2;
+}
+
+TimingSummary summarizeMeasures(const std::vector<double> & measures,
+                                double outlier_threshold)
+{
+  TimingSummary summary;
+  if (measures.empty()) return summary;
+  std::vector<double> sorted = measures;
+  std::sort(sorted.begin(), sorted.end());
+  double median = sortedMedian(sorted);
+  // Median absolute deviation, scaled to match the standard deviation of a
+  // normal distribution
+  std::vector<double> deviations;
+  for (double value : sorted) {
+    deviations.push_back(std::fabs(value - median));
+  }
+  std::sort(deviations.begin(), deviations.end());
+  double scaled_mad = 1.4826 * sortedMedian(deviations);
+  std::vector<double> kept;
+  for (double value : sorted) {
+    if (scaled_mad > 0 && std::fabs(value - median) > outlier_threshold * scaled_mad) continue;
+    kept.push_back(value);
+  }
+  int n = kept.size();
+  summary.median = sortedMedian(kept);
+  summary.nb_measures = n;
+  summary.nb_outliers = sorted.size() - n;
+  // Ranks (1-based) of the bounds of the 95% interval, from the normal
+  // approximation of the binomial distribution
+  int low_rank = (int)std::floor((n - 1.96 * std::sqrt(n)) / 2);
+  int high_rank = (int)std::ceil(1 + (n + 1.96 * std::sqrt(n)) / 2);
+  summary.ci_low = kept[std::max(1, low_rank) - 1];
+  summary.ci_high = kept[std::min(n, high_rank) - 1];
+  return summary;
+}
+
+TimingSummary measureRepeated(const std::function<double()> & measure,
+                              const TimingOptions & options)
+{
+  for (int run = 0; run < options.nb_warmup; run++) {
+    measure();
+  }
+  std::vector<double> measures;
+  std::vector<MachineState> machines;
+  TimingSummary summary;
+  double total_time = 0;
+  while (true) {
+    double duration = measure();
+    measures.push_back(duration);
+    machines.push_back(MachineState::capture());
+    total_time += duration;
+    if ((int)measures.size() < options.min_repetitions) continue;
+    summary = summarizeMeasures(measures, options.outlier_threshold);
+    double half_width = (summary.ci_high - summary.ci_low) / 2;
+    summary.stable = half_width <= options.target_precision * summary.median;
+    if (summary.stable
+        || (int)measures.size() >= options.max_repetitions
+        || total_time >= options.max_time) {
+      break;
+    }
+  }
+  summary.nb_warmup = options.nb_warmup;
+  summary.measures = measures;
+  summary.machines = machines;
+  summary.machine = MachineState::merge(machines);
+  return summary;
+}
+
+}
@@ -1,5 +1,11 @@
+#include "regression_experiments/adaptive_grid.h"
 #include "regression_experiments/benchmark_function_factory.h"
+#include "regression_experiments/expensive_function.h"
+#include "regression_experiments/perf_counters.h"
+#include "regression_experiments/prediction_exporter.h"
+#include "regression_experiments/sampling_design_factory.h"
 #include "regression_experiments/tools.h"
+#include "regression_experiments/trace_recorder.h"
 
 #include "rosban_fa/function_approximator.h"
 #include "rosban_fa/trainer_factory.h"
@@ -12,6 +18,7 @@
 
 #include <fstream>
 #include <memory>
+#include <sstream>
 
 using rosban_utils::TimeStamp;
 using rosban_fa::Trainer;
@@ -21,6 +28,65 @@ using rosban_fa::FunctionApproximator;
 namespace regression_experiments
 {
 
+std::map<std::string, std::shared_ptr<const Trainer>>
+readTrainers(TiXmlNode * node, const std::string & key, int nb_threads)
+{
+  TrainerFactory tf;
+  std::function<std::shared_ptr<const Trainer>(TiXmlNode*)> trainer_builder;
+  trainer_builder = [&tf, nb_threads](TiXmlNode * node)
+    {
+      std::shared_ptr<Trainer> trainer(tf.build(node));
+      trainer->setNbThreads(nb_threads);
+      return trainer;
+    };
+  return rosban_utils::xml_tools::read_map(node, key, trainer_builder);
+}
+
+std::map<std::string, std::shared_ptr<const BenchmarkFunction>>
+readFunctions(TiXmlNode * node, const std::string & key)
+{
+  BenchmarkFunctionFactory bff;
+  std::function<std::shared_ptr<const BenchmarkFunction>(TiXmlNode*)> bf_builder;
+  bf_builder = [&bff](TiXmlNode * node)
+    { return std::shared_ptr<BenchmarkFunction>(bff.build(node)); };
+  return rosban_utils::xml_tools::read_map(node, key, bf_builder);
+}
+
+std::unique_ptr<BenchmarkFunction> buildWithDimensions(const BenchmarkFunction & prototype,
+                                                       int nb_dimensions)
+{
+  // try_read uses the first child with the given name, therefore the new
+  // dimension overrides the one written by to_xml
+  std::ostringstream oss;
+  oss << "<function><" << prototype.class_name() << ">";
+  rosban_utils::xml_tools::write<int>("nb_dimensions", nb_dimensions, oss);
+  prototype.to_xml(oss);
+  oss << "</" << prototype.class_name() << "></function>";
+  std::string xml = oss.str();
+  TiXmlDocument doc;
+  doc.Parse(xml.c_str());
+  if (doc.Error()) {
+    throw std::runtime_error("buildWithDimensions: invalid xml '" + xml + "': "
+                             + doc.ErrorDesc());
+  }
+  std::unique_ptr<BenchmarkFunction> function = BenchmarkFunctionFactory().build(doc.RootElement());
+  if (function->getLimits().rows() != nb_dimensions) {
+    throw std::runtime_error("buildWithDimensions: '" + prototype.class_name()
+                             + "' does not support setting the number of dimensions");
+  }
+  return function;
+}
+
+std::map<std::string, std::shared_ptr<const SamplingDesign>>
+readSamplingDesigns(TiXmlNode * node, const std::string & key)
+{
+  SamplingDesignFactory sdf;
+  std::function<std::shared_ptr<const SamplingDesign>(TiXmlNode*)> sd_builder;
+  sd_builder = [&sdf](TiXmlNode * node)
+    { return std::shared_ptr<SamplingDesign>(sdf.build(node)); };
+  return rosban_utils::xml_tools::read_map(node, key, sd_builder);
+}
+
 Eigen::MatrixXd discretizeSpace(const Eigen::MatrixXd & limits,
                                 const std::vector<int> & samples_by_dim)
 {
@@ -56,6 +122,23 @@ Eigen::MatrixXd discretizeSpace(const Eigen::MatrixXd & limits,
   return points;
 }
 
+/// Draw random samples of the function and train an approximator on them
+static std::shared_ptr<const FunctionApproximator>
+trainOnRandomSamples(const BenchmarkFunction & benchmark_function,
+                     int nb_samples,
+                     const std::string & trainer_name,
+                     Eigen::MatrixXd & samples_inputs,
+                     Eigen::VectorXd & samples_outputs)
+{
+  // getting random engine
+  auto engine = rosban_random::getRandomEngine();
+  // Generating random input
+  benchmark_function.getUniformSamples(nb_samples, samples_inputs, samples_outputs, &engine);
+  // Solving
+  std::unique_ptr<Trainer> trainer(TrainerFactory().build(trainer_name));
+  return trainer->train(samples_inputs, samples_outputs, benchmark_function.getLimits());
+}
+
 void buildPrediction(const std::string & function_name,
                      int nb_samples,
                      const std::string & trainer_name,
@@ -67,17 +150,12 @@ void buildPrediction(const std::string & function_name,
                      Eigen::VectorXd & prediction_vars,
                      Eigen::MatrixXd & gradients)
 {
-  // getting random engine
-  auto engine = rosban_random::getRandomEngine();
   // Building function
   BenchmarkFunctionFactory bff;
   std::unique_ptr<BenchmarkFunction> benchmark_function(bff.build(function_name));
-  // Generating random input
-  benchmark_function->getUniformSamples(nb_samples, samples_inputs, samples_outputs, &engine);
-  // Solving
-  std::unique_ptr<Trainer> trainer(TrainerFactory().build(trainer_name));
   std::shared_ptr<const FunctionApproximator> fa;
-  fa = trainer->train(samples_inputs, samples_outputs, benchmark_function->getLimits());
+  fa = trainOnRandomSamples(*benchmark_function, nb_samples, trainer_name,
+                            samples_inputs, samples_outputs);
   // Discretizing space
   prediction_points = discretizeSpace(benchmark_function->getLimits(), points_by_dim);
   // Computing predictions and variances
@@ -95,6 +173,32 @@ void buildPrediction(const std::string & function_name,
   }
 }
 
+void buildPrediction(const std::string & function_name,
+                     int nb_samples,
+                     const std::string & trainer_name,
+                     const RefinementConfig & refinement,
+                     Eigen::MatrixXd & samples_inputs,
+                     Eigen::VectorXd & samples_outputs,
+                     Eigen::MatrixXd & prediction_points,
+                     Eigen::VectorXd & prediction_means,
+                     Eigen::VectorXd & prediction_vars,
+                     Eigen::MatrixXd & gradients)
+{
+  // Building function
+  BenchmarkFunctionFactory bff;
+  std::unique_ptr<BenchmarkFunction> benchmark_function(bff.build(function_name));
+  std::shared_ptr<const FunctionApproximator> fa;
+  fa = trainOnRandomSamples(*benchmark_function, nb_samples, trainer_name,
+                            samples_inputs, samples_outputs);
+  // Refining the grid where the prediction changes
+  AdaptivePrediction prediction;
+  prediction = buildAdaptivePrediction(fa, benchmark_function->getLimits(), refinement);
+  prediction_points = prediction.points;
+  prediction_means = prediction.means;
+  prediction_vars = prediction.vars;
+  gradients = prediction.gradients;
+}
+
 void predict(std::shared_ptr<const FunctionApproximator> fa,
              const Eigen::MatrixXd & points,
              Eigen::VectorXd & prediction_means,
@@ -115,6 +219,161 @@ void predict(std::shared_ptr<const FunctionApproximator> fa,
   }
 }
 
+void predict(std::shared_ptr<const FunctionApproximator> fa,
+             const Eigen::MatrixXf & points,
+             Eigen::VectorXf & prediction_means,
+             Eigen::VectorXf & prediction_vars)
+{
+  prediction_means = Eigen::VectorXf::Zero(points.cols());
+  prediction_vars = Eigen::VectorXf::Zero(points.cols());
+  Eigen::VectorXd point;
+  for (int i = 0; i < points.cols(); i++)
+  {
+    double mean, var;
+    point = points.col(i).cast<double>();
+    fa->predict(point, mean, var);
+    prediction_means(i) = mean;
+    prediction_vars(i) = var;
+  }
+}
+
+BenchmarkOptions::BenchmarkOptions()
+  : nb_threads(1), perf_counters(false), single_precision(false), rigorous_timing(false)
+{}
+
+BenchmarkResult::BenchmarkResult()
+  : smse(-1), learning_time(-1), prediction_time(-1), arg_max_loss(-1),
+    max_prediction_error(-1), compute_max_time(-1), sampling_time(-1),
+    max_evaluation_time(-1), data_bytes(-1), function_time(-1)
+{}
+
+std::vector<std::string> getBenchmarkPhases()
+{
+  return {"sampling", "learning", "prediction", "compute_max"};
+}
+
+/// Run 'phase' and return its duration [s], hardware counters are stored in
+/// result if 'counters' is not null. The phase is traced if recording is enabled.
+/// If 'timing' is not null, the phase is repeated according to it, the median
+/// duration is returned and the summary is stored in result. The counters kept
+/// are those of the measured run closest to the median, its index (warmup
+/// included) is stored in 'selected_run' if it is not null.
+static double runPhase(const std::string & name,
+                       PerfCounters * counters,
+                       const TimingOptions * timing,
+                       BenchmarkResult & result,
+                       const std::function<void()> & phase,
+                       size_t * selected_run = nullptr)
+{
+  std::vector<std::pair<double, PerfValues>> runs;
+  auto run_once = [&]() -> double
+    {
+      TraceScope trace(name, "phase");
+      if (counters != nullptr) counters->start();
+      TimeStamp start = TimeStamp::now();
+      phase();
+      TimeStamp end = TimeStamp::now();
+      double duration = diffSec(start, end);
+      PerfValues values;
+      if (counters != nullptr) values = counters->stop();
+      runs.push_back(std::make_pair(duration, values));
+      return duration;
+    };
+  if (timing == nullptr) {
+    double duration = run_once();
+    if (counters != nullptr) result.counters[name] = runs.back().second;
+    if (selected_run != nullptr) *selected_run = 0;
+    return duration;
+  }
+  TimingSummary summary = measureRepeated(run_once, *timing);
+  result.timings[name] = summary;
+  size_t closest = runs.size() - 1;
+  for (size_t run = timing->nb_warmup; run < runs.size(); run++) {
+    if (std::fabs(runs[run].first - summary.median)
+        < std::fabs(runs[closest].first - summary.median)) {
+      closest = run;
+    }
+  }
+  if (counters != nullptr) result.counters[name] = runs[closest].second;
+  if (selected_run != nullptr) *selected_run = closest;
+  return summary.median;
+}
+
+/// Train the approximator on the given samples and evaluate it on the test set
+/// Test data can be stored in single or double precision
+template <typename Matrix, typename Vector>
+static void evaluateTrainer(std::shared_ptr<const BenchmarkFunction> function,
+                            std::shared_ptr<const Trainer> trainer,
+                            const Eigen::MatrixXd & samples_inputs,
+                            const Eigen::VectorXd & samples_outputs,
+                            const Matrix & test_points,
+                            const Vector & test_observations,
+                            PerfCounters * counters,
+                            const TimingOptions * timing,
+                            BenchmarkResult & result)
+{
+  Eigen::MatrixXd limits = function->getLimits();
+  Vector prediction_means, prediction_vars;
+  // Solving
+  std::shared_ptr<const FunctionApproximator> fa;
+  result.learning_time = runPhase("learning", counters, timing, result, [&]()
+    {
+      fa = trainer->train(samples_inputs, samples_outputs, limits);
+    });
+  // Getting predictions for test points
+  result.prediction_time = runPhase("prediction", counters, timing, result, [&]()
+    {
+      predict(fa, test_points, prediction_means, prediction_vars);
+    });
+
+  // Computing max
+  Eigen::VectorXd best_input;
+  double expected_max, measured_max;
+  result.compute_max_time = runPhase("compute_max", counters, timing, result, [&]()
+    {
+      fa->getMaximum(limits, best_input, expected_max);
+    });
+  // sampleBatch is noise-free, a single evaluation is enough. It is used
+  // instead of sample so that pooled functions account for this evaluation
+  TimeStamp evaluation_start = TimeStamp::now();
+  measured_max = function->sampleBatch(best_input, 1)(0);
+  result.max_evaluation_time = diffSec(evaluation_start, TimeStamp::now());
+
+  try{
+    result.arg_max_loss = function->getMax() - measured_max;
+    result.max_prediction_error = std::fabs(expected_max - measured_max);
+  }
+  catch(const std::runtime_error & exc) {
+    result.arg_max_loss = -1;
+    result.max_prediction_error = -1;
+    std::cerr << exc.what() << std::endl;
+  }
+
+  // Computing output values
+  result.smse = rosban_gp::computeSMSE(test_observations.template cast<double>(),
+                                       prediction_means.template cast<double>());
+
+  // Temporary disabling debug (not implemented for all trainers)
+  //double suspicion_min = std::pow(10,2);
+  //if (smse > suspicion_min) {
+  //  std::cout << "Large smse: tracking debugs" << std::endl;
+  //  for (int sample = 0; sample < test_points.cols(); sample++) {
+  //    double observation = test_observations(sample);
+  //    double prediction = prediction_means(sample);
+  //    double prediction_var = prediction_vars(sample);
+  //    double diff2 = std::pow(observation - prediction, 2);
+  //    if (diff2 > suspicion_min) {
+  //      std::cout << "\tsample " << sample << ":" << std::endl;
+  //      std::cout << "\t\tprediction     : " << prediction      << std::endl
+  //                << "\t\tprediction var : " << prediction_var  << std::endl
+  //                << "\t\tobservation    : " << observation     << std::endl
+  //                << "\t\tdiff2          : " << diff2           << std::endl;
+  //      fa->debugPrediction(test_points.col(sample), std::cout);
+  //    }
+  //  }
+  //}
+}
+
 void runBenchmark(const std::string & function_name,
                   int nb_samples,
                   const std::string & trainer_name,
@@ -159,8 +418,8 @@ void runBenchmark(std::shared_ptr<const BenchmarkFunction> function,
   Eigen::MatrixXd samples_inputs;
   Eigen::VectorXd samples_outputs;
   Eigen::MatrixXd test_points;
-  Eigen::VectorXd test_observations, prediction_means, prediction_vars;
-                    
+  Eigen::VectorXd test_observations;
+
   bool clean_engine = false;
   // getting random engine
   if (engine == NULL) {
@@ -170,69 +429,105 @@ void runBenchmark(std::shared_ptr<const BenchmarkFunction> function,
   // Generating samples and test points
   function->getUniformSamples(nb_samples, samples_inputs, samples_outputs, engine);
   function->getUniformSamples(nb_test_points, test_points, test_observations, engine);
-  // Solving
-  TimeStamp learning_start = TimeStamp::now();
-  std::shared_ptr<const FunctionApproximator> fa;
-  fa = trainer->train(samples_inputs, samples_outputs, function->getLimits());
-  TimeStamp learning_end = TimeStamp::now();
-  // Getting predictions for test points
-  TimeStamp prediction_start = TimeStamp::now();
-  predict(fa, test_points, prediction_means, prediction_vars);
-  TimeStamp prediction_end = TimeStamp::now();
-  // Evaluating prediction
   // Clean engine if necessary
   if (clean_engine) {
     delete(engine);
   }
+  BenchmarkResult result;
+  evaluateTrainer(function, trainer,
+                  samples_inputs, samples_outputs, test_points, test_observations,
+                  nullptr, nullptr, result);
+  smse                 = result.smse;
+  learning_time        = result.learning_time;
+  prediction_time      = result.prediction_time;
+  arg_max_loss         = result.arg_max_loss;
+  max_prediction_error = result.max_prediction_error;
+  compute_max_time     = result.compute_max_time;
+}
 
-  // Computing max
-  Eigen::VectorXd best_input;
-  double expected_max, measured_max;
-  TimeStamp get_max_start = TimeStamp::now();
-  fa->getMaximum(function->getLimits(), best_input, expected_max);
-  TimeStamp get_max_end = TimeStamp::now();
-  int nb_max_tests = 1000;
-  measured_max = 0;
-  for (int i = 0; i < nb_max_tests; i++) {
-    measured_max += function->sample(best_input);
+/// Generate samples and test points stored with the given scalar type and
+/// evaluate the trainer on them
+template <typename Scalar>
+static void runStoredBenchmark(std::shared_ptr<const BenchmarkFunction> function,
+                               int nb_samples,
+                               std::shared_ptr<const Trainer> trainer,
+                               int nb_test_points,
+                               const RandomStream & stream,
+                               const BenchmarkOptions & options,
+                               PerfCounters * counters,
+                               BenchmarkResult & result)
+{
+  typedef Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic> Matrix;
+  typedef Eigen::Matrix<Scalar, Eigen::Dynamic, 1> Vector;
+  const TimingOptions * timing = options.rigorous_timing ? &options.timing : nullptr;
+  // Internal data: trainers require double precision, hence training samples
+  // are stored once in double precision, rounded to Scalar precision
+  Eigen::MatrixXd samples_inputs;
+  Eigen::VectorXd samples_outputs;
+  Matrix test_points;
+  Vector test_observations;
+  // Evaluation time of an expensive function for each run of the sampling
+  // phase, only the selected run is reported
+  const ExpensiveFunction * expensive = dynamic_cast<const ExpensiveFunction *>(function.get());
+  std::vector<double> sampling_evaluation_times;
+  size_t sampling_run = 0;
+  // Generating samples and test points
+  result.sampling_time = runPhase("sampling", counters, timing, result, [&]()
+    {
+      double evaluation_start = expensive ? expensive->getThreadEvaluationTime() : 0;
+      UniformDesign uniform_design;
+      const SamplingDesign * design = &uniform_design;
+      if (options.sampling_design) design = options.sampling_design.get();
+      function->getSamples(nb_samples, samples_inputs, samples_outputs, *design,
+                           stream.withPurpose(RandomPurpose::TrainingSamples),
+                           true, options.nb_threads);
+      // Coefficient-wise rounding in place, no temporary copy is created
+      samples_inputs = samples_inputs.cast<Scalar>().template cast<double>();
+      samples_outputs = samples_outputs.cast<Scalar>().template cast<double>();
+      function->getUniformSamples(nb_test_points, test_points, test_observations,
+                                  stream.withPurpose(RandomPurpose::TestSamples),
+                                  true, options.nb_threads);
+      if (expensive) {
+        sampling_evaluation_times.push_back(expensive->getThreadEvaluationTime()
+                                            - evaluation_start);
+      }
+    }, &sampling_run);
+  // The trainer never calls the function, only the maximum is evaluated
+  double evaluation_start = expensive ? expensive->getThreadEvaluationTime() : 0;
+  evaluateTrainer(function, trainer, samples_inputs, samples_outputs,
+                  test_points, test_observations,
+                  counters, timing, result);
+  if (expensive) {
+    result.function_time = sampling_evaluation_times[sampling_run]
+      + expensive->getThreadEvaluationTime() - evaluation_start;
   }
-  measured_max /= nb_max_tests;
+  // Samples in double precision, test points, test observations, prediction
+  // means and variances in Scalar precision
+  long nb_training_values = samples_inputs.size() + samples_outputs.size();
+  long nb_test_values = test_points.size() + test_observations.size() + 2 * (long)nb_test_points;
+  result.data_bytes = nb_training_values * sizeof(double) + nb_test_values * sizeof(Scalar);
+}
 
-  try{
-    arg_max_loss = function->getMax() - measured_max;
-    max_prediction_error = std::fabs(expected_max - measured_max);
+void runBenchmark(std::shared_ptr<const BenchmarkFunction> function,
+                  int nb_samples,
+                  std::shared_ptr<const Trainer> trainer,
+                  int nb_test_points,
+                  const RandomStream & stream,
+                  const BenchmarkOptions & options,
+                  BenchmarkResult & result)
+{
+  std::unique_ptr<PerfCounters> counters;
+  if (options.perf_counters) {
+    counters.reset(new PerfCounters());
   }
-  catch(const std::runtime_error & exc) {
-    arg_max_loss = -1;
-    max_prediction_error = -1;
-    std::cerr << exc.what() << std::endl;
+  if (options.single_precision) {
+    runStoredBenchmark<float>(function, nb_samples, trainer, nb_test_points,
+                              stream, options, counters.get(), result);
+  }
+  else {
+    runStoredBenchmark<double>(function, nb_samples, trainer, nb_test_points,
+                               stream, options, counters.get(), result);
   }
-
-  // Computing output values
-  smse = rosban_gp::computeSMSE(test_observations, prediction_means);
-  learning_time = diffSec(learning_start, learning_end);
-  prediction_time = diffSec(prediction_start, prediction_end);
-  compute_max_time = diffSec(get_max_start, get_max_end);
-
-  // Temporary disabling debug (not implemented for all trainers)
-  //double suspicion_min = std::pow(10,2);
-  //if (smse > suspicion_min) {
-  //  std::cout << "Large smse: tracking debugs" << std::endl;
-  //  for (int sample = 0; sample < nb_test_points; sample++) {
-  //    double observation = test_observations(sample);
-  //    double prediction = prediction_means(sample);
-  //    double prediction_var = prediction_vars(sample);
-  //    double diff2 = std::pow(observation - prediction, 2);
-  //    if (diff2 > suspicion_min) {
-  //      std::cout << "\tsample " << sample << ":" << std::endl;
-  //      std::cout << "\t\tprediction     : " << prediction      << std::endl
-  //                << "\t\tprediction var : " << prediction_var  << std::endl
-  //                << "\t\tobservation    : " << observation     << std::endl
-  //                << "\t\tdiff2          : " << diff2           << std::endl;
-  //      fa->debugPrediction(test_points.col(sample), std::cout);
-  //    }
-  //  }
-  //}
 }
 
 void writePrediction(const std::string & path,
@@ -243,34 +538,9 @@ void writePrediction(const std::string & path,
                      const Eigen::VectorXd & prediction_vars,
                      const Eigen::MatrixXd & gradients)
 {
-  // Writing predictions + points
-  std::ofstream out;
-  out.open(path);
-  out << "type,input,mean,min,max,gradient" << std::endl;
-
-  // Writing Ref points
-  for (int i = 0; i < samples_inputs.cols(); i++)
-  {
-    // write with the same format but min and max carry no meaning
-    out << "observation," << samples_inputs(0,i) << ","
-        << samples_outputs(i) << ",0,0,0" << std::endl;
-  }
-
-  // Writing predictions
-  for (int point = 0; point < prediction_points.cols(); point++)
-  {
-    Eigen::VectorXd prediction_input = prediction_points.col(point);
-    double mean = prediction_means(point);
-    double var  = prediction_vars(point);
-    // Getting +- 2 stddev
-    double interval = 2 * std::sqrt(var);
-    double min = mean - interval;
-    double max = mean + interval;
-    // Writing line
-    out << "prediction," << prediction_input(0) << ","
-        << mean << "," << min << "," << max << "," << gradients(0,point) << std::endl;
-  }
-  out.close();
+  PredictionExporter exporter(path, samples_inputs.rows());
+  exporter.writeObservations(samples_inputs, samples_outputs);
+  exporter.writePredictions(prediction_points, prediction_means, prediction_vars, gradients);
 }
 
 }
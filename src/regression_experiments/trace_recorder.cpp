@@ -0,0 +1,148 @@
+#include "regression_experiments/trace_recorder.h"
+
+#include <fstream>
+#include <stdexcept>
+
+namespace regression_experiments
+{
+
+std::string escapeJson(const std::string & str)
+{
+  std::string result;
+  result.reserve(str.size());
+  for (char c : str) {
+    switch (c) {
+      case '"':  result += "\\\""; break;
+      case '\\': result += "\\\\"; break;
+      case '\n': result += "\\n";  break;
+      case '\t': result += "\\t";  break;
+      default:
+        if ((unsigned char)c < 0x20) continue;
+        result += c;
+    }
+  }
+  return result;
+}
+
+TraceRecorder::TraceRecorder()
+  : enabled(false), start(std::chrono::steady_clock::now())
+{}
+
+TraceRecorder & TraceRecorder::getInstance()
+{
+  static TraceRecorder instance;
+  return instance;
+}
+
+void TraceRecorder::enable()
+{
+  enabled = true;
+}
+
+bool TraceRecorder::isEnabled() const
+{
+  return enabled.load(std::memory_order_relaxed);
+}
+
+void TraceRecorder::begin(const std::string & name, const std::string & category,
+                          const Args & args)
+{
+  if (!isEnabled()) return;
+  record('B', name, category, args);
+}
+
+void TraceRecorder::end(const std::string & name, const std::string & category)
+{
+  if (!isEnabled()) return;
+  record('E', name, category, Args());
+}
+
+void TraceRecorder::setThreadName(const std::string & name)
+{
+  if (!isEnabled()) return;
+  getThreadBuffer().thread_name = name;
+}
+
+TraceRecorder::ThreadBuffer & TraceRecorder::getThreadBuffer()
+{
+  // Buffers are owned by the recorder, they remain valid after the end of the thread
+  static thread_local ThreadBuffer * buffer = nullptr;
+  if (buffer == nullptr) {
+    std::lock_guard<std::mutex> lock(buffers_mutex);
+    buffers.push_back(std::unique_ptr<ThreadBuffer>(new ThreadBuffer()));
+    buffer = buffers.back().get();
+    buffer->tid = buffers.size();
+    buffer->events.reserve(1024);
+  }
+  return *buffer;
+}
+
+void TraceRecorder::record(char phase, const std::string & name, const std::string & category,
+                           const Args & args)
+{
+  std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+  Event event;
+  event.phase = phase;
+  event.name = name;
+  event.category = category;
+  event.timestamp = elapsed.count();
+  event.args = args;
+  getThreadBuffer().events.push_back(std::move(event));
+}
+
+void TraceRecorder::writeJson(const std::string & path) const
+{
+  std::ofstream out(path);
+  if (!out.good()) {
+    throw std::runtime_error("TraceRecorder::writeJson: failed to open '" + path + "'");
+  }
+  out.precision(15);
+  out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+  bool first = true;
+  for (const std::unique_ptr<ThreadBuffer> & buffer : buffers) {
+    if (buffer->thread_name != "") {
+      out << (first ? "" : ",\n")
+          << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << buffer->tid
+          << ",\"args\":{\"name\":\"" << escapeJson(buffer->thread_name) << "\"}}";
+      first = false;
+    }
+    for (const Event & event : buffer->events) {
+      out << (first ? "" : ",\n")
+          << "{\"ph\":\"" << event.phase << "\""
+          << ",\"name\":\"" << escapeJson(event.name) << "\""
+          << ",\"cat\":\"" << escapeJson(event.category) << "\""
+          << ",\"ts\":" << event.timestamp
+          << ",\"pid\":1,\"tid\":" << buffer->tid;
+      if (event.args.size() > 0) {
+        out << ",\"args\":{";
+        for (size_t i = 0; i < event.args.size(); i++) {
+          out << (i == 0 ? "" : ",")
+              << "\"" << escapeJson(event.args[i].first) << "\":"
+              << "\"" << escapeJson(event.args[i].second) << "\"";
+        }
+        out << "}";
+      }
+      out << "}";
+      first = false;
+    }
+  }
+  out << "\n]}\n";
+}
+
+TraceScope::TraceScope(const std::string & name_, const std::string & category_,
+                       const TraceRecorder::Args & args)
+  : active(TraceRecorder::getInstance().isEnabled())
+{
+  if (!active) return;
+  name = name_;
+  category = category_;
+  TraceRecorder::getInstance().begin(name, category, args);
+}
+
+TraceScope::~TraceScope()
+{
+  if (!active) return;
+  TraceRecorder::getInstance().end(name, category);
+}
+
+}
@@ -0,0 +1,332 @@
+#include "regression_experiments/tuning.h"
+
+#include "regression_experiments/parallel.h"
+#include "regression_experiments/tools.h"
+#include "regression_experiments/trace_recorder.h"
+
+#include "rosban_fa/trainer_factory.h"
+
+#include "rosban_gp/scoring.h"
+
+#include "rosban_utils/time_stamp.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <set>
+#include <sstream>
+
+using rosban_fa::FunctionApproximator;
+using rosban_fa::Trainer;
+using rosban_fa::TrainerFactory;
+using rosban_utils::TimeStamp;
+
+namespace regression_experiments
+{
+
+std::vector<ParameterValues> ParameterSpace::getGrid() const
+{
+  std::vector<ParameterValues> grid(1);
+  for (const auto & parameter : parameters) {
+    std::vector<ParameterValues> next_grid;
+    for (const ParameterValues & values : grid) {
+      for (const std::string & value : parameter.second) {
+        ParameterValues candidate = values;
+        candidate[parameter.first] = value;
+        next_grid.push_back(candidate);
+      }
+    }
+    grid = next_grid;
+  }
+  return grid;
+}
+
+std::vector<ParameterValues>
+ParameterSpace::getRandomCandidates(int nb_candidates, const RandomStream & stream) const
+{
+  size_t grid_size = 1;
+  for (const auto & parameter : parameters) {
+    grid_size *= parameter.second.size();
+  }
+  std::vector<ParameterValues> candidates;
+  std::set<std::string> known;
+  // Each draw uses one element of the stream per parameter
+  uint64_t offset = 0;
+  while ((int)candidates.size() < nb_candidates && known.size() < grid_size) {
+    ParameterValues candidate;
+    for (const auto & parameter : parameters) {
+      double u;
+      stream.uniform(offset++, 1, &u);
+      int nb_values = parameter.second.size();
+      int index = std::min(nb_values - 1, (int)((1 - u) * nb_values));
+      candidate[parameter.first] = parameter.second[index];
+    }
+    if (known.insert(toString(candidate)).second) {
+      candidates.push_back(candidate);
+    }
+  }
+  return candidates;
+}
+
+std::string ParameterSpace::getTrainerXml(const ParameterValues & values) const
+{
+  std::ostringstream oss;
+  oss << "<" << trainer_name << ">";
+  for (const auto & entry : fixed) {
+    if (values.count(entry.first) > 0) continue;
+    oss << "<" << entry.first << ">" << entry.second << "</" << entry.first << ">";
+  }
+  for (const auto & entry : values) {
+    oss << "<" << entry.first << ">" << entry.second << "</" << entry.first << ">";
+  }
+  oss << "</" << trainer_name << ">";
+  return oss.str();
+}
+
+std::unique_ptr<Trainer> ParameterSpace::buildTrainer(const ParameterValues & values,
+                                                      int nb_threads) const
+{
+  std::string xml = "<trainer>" + getTrainerXml(values) + "</trainer>";
+  TiXmlDocument doc;
+  doc.Parse(xml.c_str());
+  if (doc.Error()) {
+    throw std::runtime_error("ParameterSpace::buildTrainer: invalid xml '" + xml + "': "
+                             + doc.ErrorDesc());
+  }
+  std::unique_ptr<Trainer> trainer = TrainerFactory().build(doc.RootElement());
+  trainer->setNbThreads(nb_threads);
+  return trainer;
+}
+
+std::string ParameterSpace::toString(const ParameterValues & values)
+{
+  std::ostringstream oss;
+  bool first = true;
+  for (const auto & entry : values) {
+    if (!first) oss << ";";
+    oss << entry.first << "=" << entry.second;
+    first = false;
+  }
+  return oss.str();
+}
+
+std::string ParameterSpace::class_name() const
+{
+  return "parameter_space";
+}
+
+void ParameterSpace::to_xml(std::ostream &out) const
+{
+  rosban_utils::xml_tools::write<std::string>("trainer", trainer_name, out);
+  out << "<fixed>";
+  for (const auto & entry : fixed) {
+    out << "<entry>";
+    rosban_utils::xml_tools::write<std::string>("key", entry.first, out);
+    out << "<val>";
+    rosban_utils::xml_tools::write<std::string>("value", entry.second, out);
+    out << "</val>";
+    out << "</entry>";
+  }
+  out << "</fixed>";
+  out << "<parameters>";
+  for (const auto & entry : parameters) {
+    out << "<entry>";
+    rosban_utils::xml_tools::write<std::string>("key", entry.first, out);
+    out << "<val>";
+    rosban_utils::xml_tools::write_vector<std::string>("values", entry.second, out);
+    out << "</val>";
+    out << "</entry>";
+  }
+  out << "</parameters>";
+}
+
+void ParameterSpace::from_xml(TiXmlNode *node)
+{
+  trainer_name = rosban_utils::xml_tools::read<std::string>(node, "trainer");
+  fixed.clear();
+  parameters.clear();
+  if (node->FirstChild("fixed") != NULL) {
+    std::function<std::string(TiXmlNode*)> fixed_builder = [](TiXmlNode * node)
+      { return rosban_utils::xml_tools::read<std::string>(node, "value"); };
+    fixed = rosban_utils::xml_tools::read_map(node, "fixed", fixed_builder);
+  }
+  std::function<std::vector<std::string>(TiXmlNode*)> values_builder = [](TiXmlNode * node)
+    { return rosban_utils::xml_tools::read_vector<std::string>(node, "values"); };
+  parameters = rosban_utils::xml_tools::read_map(node, "parameters", values_builder);
+  for (const auto & parameter : parameters) {
+    if (parameter.second.empty()) {
+      throw std::runtime_error("ParameterSpace: no values for '" + parameter.first + "'");
+    }
+  }
+}
+
+std::vector<CrossValidationFold> buildFolds(const Eigen::MatrixXd & inputs,
+                                            const Eigen::VectorXd & observations,
+                                            int nb_folds)
+{
+  int nb_samples = inputs.cols();
+  if (nb_folds < 2 || nb_folds > nb_samples) {
+    throw std::runtime_error("buildFolds: nb_folds should be in [2, nb_samples]");
+  }
+  std::vector<CrossValidationFold> folds(nb_folds);
+  for (int fold_id = 0; fold_id < nb_folds; fold_id++) {
+    CrossValidationFold & fold = folds[fold_id];
+    int nb_validation = nb_samples / nb_folds + (fold_id < nb_samples % nb_folds ? 1 : 0);
+    int nb_training = nb_samples - nb_validation;
+    fold.training_inputs.resize(inputs.rows(), nb_training);
+    fold.training_observations.resize(nb_training);
+    fold.validation_inputs.resize(inputs.rows(), nb_validation);
+    fold.validation_observations.resize(nb_validation);
+    int training_id = 0, validation_id = 0;
+    for (int sample = 0; sample < nb_samples; sample++) {
+      if (sample % nb_folds == fold_id) {
+        fold.validation_inputs.col(validation_id) = inputs.col(sample);
+        fold.validation_observations(validation_id) = observations(sample);
+        validation_id++;
+      }
+      else {
+        fold.training_inputs.col(training_id) = inputs.col(sample);
+        fold.training_observations(training_id) = observations(sample);
+        training_id++;
+      }
+    }
+  }
+  return folds;
+}
+
+TuningCandidate::TuningCandidate()
+  : pruned_rung(-1)
+{}
+
+double TuningCandidate::getMeanSMSE() const
+{
+  double total = 0;
+  for (const FoldScore & score : scores) total += score.smse;
+  return total / scores.size();
+}
+
+double TuningCandidate::getMeanLearningTime() const
+{
+  double total = 0;
+  for (const FoldScore & score : scores) total += score.learning_time;
+  return total / scores.size();
+}
+
+double TuningCandidate::getMeanPredictionTime() const
+{
+  double total = 0;
+  for (const FoldScore & score : scores) total += score.prediction_time;
+  return total / scores.size();
+}
+
+/// Train on the training set of the fold and score on its validation set
+static FoldScore evaluateFold(const Trainer & trainer,
+                              const CrossValidationFold & fold,
+                              const Eigen::MatrixXd & limits)
+{
+  FoldScore score;
+  TimeStamp learning_start = TimeStamp::now();
+  std::shared_ptr<const FunctionApproximator> fa;
+  fa = trainer.train(fold.training_inputs, fold.training_observations, limits);
+  TimeStamp prediction_start = TimeStamp::now();
+  Eigen::VectorXd means, vars;
+  predict(fa, fold.validation_inputs, means, vars);
+  TimeStamp prediction_end = TimeStamp::now();
+  score.smse = rosban_gp::computeSMSE(fold.validation_observations, means);
+  // Candidates are sorted by smse, nan would break the ordering
+  if (std::isnan(score.smse)) score.smse = std::numeric_limits<double>::infinity();
+  score.learning_time = diffSec(learning_start, prediction_start);
+  score.prediction_time = diffSec(prediction_start, prediction_end);
+  return score;
+}
+
+int runSuccessiveHalving(std::vector<TuningCandidate> & candidates,
+                         const std::vector<CrossValidationFold> & folds,
+                         const Eigen::MatrixXd & limits,
+                         double eta,
+                         int nb_workers)
+{
+  if (candidates.empty()) {
+    throw std::runtime_error("runSuccessiveHalving: no candidates");
+  }
+  int nb_folds = folds.size();
+  std::vector<int> alive;
+  for (size_t candidate = 0; candidate < candidates.size(); candidate++) {
+    alive.push_back(candidate);
+  }
+  // Number of rungs required to keep a single candidate
+  int nb_rungs = 1;
+  if (eta >= 2) {
+    for (int nb_alive = alive.size(); nb_alive > 1; nb_rungs++) {
+      nb_alive = (int)std::ceil(nb_alive / eta);
+    }
+  }
+  // Folds evaluated at each rung, rungs which would not evaluate any new fold
+  // are merged with the next one, otherwise candidates would be pruned twice
+  // on the same scores
+  std::vector<int> rungs_folds;
+  for (int rung = 0; rung < nb_rungs; rung++) {
+    int rung_folds = (int)std::ceil(nb_folds / std::pow(eta, nb_rungs - 1 - rung));
+    rung_folds = std::max(1, std::min(nb_folds, rung_folds));
+    if (!rungs_folds.empty() && rung_folds <= rungs_folds.back()) continue;
+    rungs_folds.push_back(rung_folds);
+  }
+  nb_rungs = rungs_folds.size();
+  for (int rung = 0; rung < nb_rungs; rung++) {
+    int rung_folds = rungs_folds[rung];
+    // (candidate, fold) pairs not evaluated yet
+    std::vector<std::pair<int, int>> jobs;
+    for (int candidate : alive) {
+      TuningCandidate & c = candidates[candidate];
+      int first_fold = c.scores.size();
+      c.scores.resize(rung_folds);
+      for (int fold = first_fold; fold < rung_folds; fold++) {
+        jobs.push_back(std::pair<int, int>(candidate, fold));
+      }
+    }
+    TraceScope trace("rung", "tuning",
+                     {{"rung", std::to_string(rung)},
+                      {"nb_candidates", std::to_string(alive.size())},
+                      {"nb_folds", std::to_string(rung_folds)}});
+    // Each job writes its own score
+    runParallel(jobs.size(), nb_workers, [&](int start, int end)
+                {
+                  for (int job = start; job < end; job++) {
+                    TuningCandidate & c = candidates[jobs[job].first];
+                    int fold = jobs[job].second;
+                    try {
+                      c.scores[fold] = evaluateFold(*c.trainer, folds[fold], limits);
+                    }
+                    catch (const std::runtime_error & exc) {
+                      // A failing candidate is dominated by all the others
+                      std::cerr << "Candidate '" << ParameterSpace::toString(c.values)
+                                << "' failed on fold " << fold << ": " << exc.what() << std::endl;
+                      c.scores[fold].smse = std::numeric_limits<double>::infinity();
+                      c.scores[fold].learning_time = -1;
+                      c.scores[fold].prediction_time = -1;
+                    }
+                  }
+                });
+    if (rung == nb_rungs - 1) break;
+    // Keeping the best candidates
+    std::stable_sort(alive.begin(), alive.end(), [&candidates](int a, int b)
+                     {
+                       return candidates[a].getMeanSMSE() < candidates[b].getMeanSMSE();
+                     });
+    int nb_kept = (int)std::ceil(alive.size() / eta);
+    for (size_t i = nb_kept; i < alive.size(); i++) {
+      candidates[alive[i]].pruned_rung = rung;
+    }
+    alive.resize(nb_kept);
+  }
+  int best = alive[0];
+  for (int candidate : alive) {
+    if (candidates[candidate].getMeanSMSE() < candidates[best].getMeanSMSE()) {
+      best = candidate;
+    }
+  }
+  return best;
+}
+
+}
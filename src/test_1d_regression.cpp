@@ -15,7 +15,10 @@ using rosban_gp::GaussianProcess;
 int main(int argc, char ** argv)
 {
   if (argc < 3) {
-    std::cerr << "Usage: " << argv[0] << " <function_name> <trainer_name>" << std::endl;
+    std::cerr << "Usage: " << argv[0] << " <function_name> <trainer_name> [mean_tolerance]"
+              << std::endl
+              << "\tIf mean_tolerance is provided, the prediction grid is refined where"
+              << " the mean varies by more than mean_tolerance" << std::endl;
     exit(EXIT_FAILURE);
   }
   std::string function_name(argv[1]);
@@ -30,16 +33,37 @@ int main(int argc, char ** argv)
   Eigen::MatrixXd prediction_points, gradients;
   Eigen::VectorXd prediction_means, prediction_vars;
 
-  buildPrediction(function_name,
-                  nb_samples,
-                  trainer_name,
-                  {nb_prediction_points},
-                  samples_inputs,
-                  samples_outputs,
-                  prediction_points,
-                  prediction_means,
-                  prediction_vars,
-                  gradients);
+  if (argc > 3) {
+    // 32 cells split up to 5 times: finest resolution close to the regular grid
+    RefinementConfig refinement;
+    refinement.initial_points_by_dim = {33};
+    refinement.max_depth = 5;
+    refinement.mean_tolerance = std::stod(argv[3]);
+    refinement.max_points = nb_prediction_points;
+    buildPrediction(function_name,
+                    nb_samples,
+                    trainer_name,
+                    refinement,
+                    samples_inputs,
+                    samples_outputs,
+                    prediction_points,
+                    prediction_means,
+                    prediction_vars,
+                    gradients);
+    std::cout << "Predicted " << prediction_points.cols() << " points" << std::endl;
+  }
+  else {
+    buildPrediction(function_name,
+                    nb_samples,
+                    trainer_name,
+                    {nb_prediction_points},
+                    samples_inputs,
+                    samples_outputs,
+                    prediction_points,
+                    prediction_means,
+                    prediction_vars,
+                    gradients);
+  }
 
   std::ostringstream oss;
   oss << function_name << "_" << nb_samples << "_" << trainer_name << ".csv";
@@ -0,0 +1,57 @@
+#include "regression_experiments/sequential_design.h"
+
+#include "rosban_fa/trainer_factory.h"
+
+#include <iostream>
+
+using namespace regression_experiments;
+
+using rosban_fa::Trainer;
+using rosban_fa::TrainerFactory;
+
+/// Paraboloid which does not provide its maximum
+class UnknownMaxFunction : public BenchmarkFunction
+{
+public:
+  virtual Eigen::MatrixXd getLimits() const override
+    {
+      Eigen::MatrixXd limits(2, 2);
+      limits << -1, 1,
+                -1, 1;
+      return limits;
+    }
+
+  virtual double sample(const Eigen::VectorXd & input) const override
+    {
+      return -input.squaredNorm();
+    }
+
+  virtual std::string class_name() const override
+    {
+      return "unknown_max_function";
+    }
+};
+
+/// The sequential design should run to completion on a function without
+/// known maximum and report the regret and the loss as -1
+int main()
+{
+  std::shared_ptr<const BenchmarkFunction> function(new UnknownMaxFunction());
+  std::shared_ptr<const Trainer> trainer(TrainerFactory().build("PWLForestTrainer"));
+  int nb_iterations = 5;
+  std::vector<SequentialIteration> iterations;
+  iterations = runSequentialDesign(function, trainer, 10, nb_iterations, RandomStream(1));
+  bool success = (int)iterations.size() == nb_iterations;
+  for (const SequentialIteration & iteration : iterations) {
+    if (iteration.arg_max_loss != -1 || iteration.simple_regret != -1) {
+      success = false;
+    }
+  }
+  if (!success) {
+    std::cerr << "test_sequential_design: expected " << nb_iterations
+              << " iterations with regret and loss -1" << std::endl;
+    return EXIT_FAILURE;
+  }
+  std::cout << "test_sequential_design: OK" << std::endl;
+  return EXIT_SUCCESS;
+}
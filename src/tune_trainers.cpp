@@ -0,0 +1,208 @@
+#include "regression_experiments/tools.h"
+#include "regression_experiments/trace_recorder.h"
+#include "regression_experiments/tuning.h"
+
+#include "rosban_utils/time_stamp.h"
+
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <random>
+
+using namespace regression_experiments;
+
+using rosban_utils::TimeStamp;
+
+class TuningConfig : public rosban_utils::Serializable
+{
+public:
+  /// Which parameters are tuned for each trainer? name -> parameter space
+  std::map<std::string, ParameterSpace> methods;
+  /// Which functions are used? name -> function
+  std::map<std::string, std::shared_ptr<const BenchmarkFunction>> functions;
+  /// Number of samples shared by all the folds
+  int nb_samples;
+  /// Number of folds of the cross-validation
+  int nb_folds;
+  /// 'grid' or 'random'
+  std::string search;
+  /// Number of candidates for the random search
+  int nb_random_candidates;
+  /// Ratio of candidates discarded at each rung of successive halving,
+  /// values lower than 2 disable pruning
+  double eta;
+  /// Number of threads allowed for each trainer
+  int nb_threads;
+  /// Number of (candidate, fold) evaluations run simultaneously
+  int nb_workers;
+  /// If not empty, a Chrome trace of the tuning is written at this path
+  std::string trace_path;
+  /// Seed of the random streams, drawn randomly if not provided
+  uint32_t seed;
+
+  std::string class_name() const override
+    {
+      return "tuning_config";
+    }
+
+  void to_xml(std::ostream &out) const override
+    {
+      (void) out;
+      throw std::logic_error("TuningConfig::to_xml: Not implemented");
+    }
+
+  void from_xml(TiXmlNode *node)
+    {
+      nb_samples = rosban_utils::xml_tools::read<int>(node, "nb_samples");
+      nb_folds   = rosban_utils::xml_tools::read<int>(node, "nb_folds"  );
+      nb_threads = rosban_utils::xml_tools::read<int>(node, "nb_threads");
+      search = "grid";
+      nb_random_candidates = 20;
+      eta = 3;
+      nb_workers = 1;
+      rosban_utils::xml_tools::try_read<std::string>(node, "search"              , search              );
+      rosban_utils::xml_tools::try_read<int>        (node, "nb_random_candidates", nb_random_candidates);
+      rosban_utils::xml_tools::try_read<double>     (node, "eta"                 , eta                 );
+      rosban_utils::xml_tools::try_read<int>        (node, "nb_workers"          , nb_workers          );
+      rosban_utils::xml_tools::try_read<std::string>(node, "trace_path"          , trace_path          );
+      if (search != "grid" && search != "random") {
+        throw std::runtime_error("TuningConfig: unknown search '" + search + "'");
+      }
+      int read_seed = -1;
+      rosban_utils::xml_tools::try_read<int>(node, "seed", read_seed);
+      seed = read_seed >= 0 ? (uint32_t)read_seed : std::random_device()();
+      // Read methods and functions
+      std::function<ParameterSpace(TiXmlNode*)> space_builder = [](TiXmlNode * node)
+        {
+          ParameterSpace space;
+          space.read(node, "parameter_space");
+          return space;
+        };
+      methods = rosban_utils::xml_tools::read_map(node, "methods", space_builder);
+      functions = readFunctions(node, "functions");
+    }
+};
+
+/// Best candidate of a method and cost of the tuning
+struct MethodSummary
+{
+  std::string method_name;
+  TuningCandidate best;
+  int nb_candidates;
+  int nb_evaluations;
+  double evaluation_time;
+  double tuning_time;
+};
+
+int main()
+{
+  TuningConfig conf;
+  conf.load_file();
+
+  std::cout << "Using seed: " << conf.seed << std::endl;
+  if (conf.trace_path != "") {
+    TraceRecorder::getInstance().enable();
+    TraceRecorder::getInstance().setThreadName("main");
+  }
+
+  std::ofstream candidates_out("tuning_candidates.csv");
+  candidates_out << "function_name,method,parameters,nb_folds,pruned_rung,"
+                 << "smse,learning_time,prediction_time" << std::endl;
+  std::ofstream best_out("tuning_best.csv");
+  best_out << "function_name,method,parameters,smse,learning_time,prediction_time,"
+           << "nb_candidates,nb_evaluations,evaluation_time,tuning_time,best_for_function"
+           << std::endl;
+
+  int function_id = -1;
+  for (auto & function_entry : conf.functions) {
+    function_id++;
+    const std::string & function_name = function_entry.first;
+    std::shared_ptr<const BenchmarkFunction> function = function_entry.second;
+    Eigen::MatrixXd limits = function->getLimits();
+    // Folds are built once and shared by all the candidates
+    RandomStream stream(conf.seed, function_id, 0);
+    Eigen::MatrixXd inputs;
+    Eigen::VectorXd observations;
+    function->getUniformSamples(conf.nb_samples, inputs, observations,
+                                stream.withPurpose(RandomPurpose::TrainingSamples),
+                                true, conf.nb_threads);
+    const std::vector<CrossValidationFold> folds = buildFolds(inputs, observations, conf.nb_folds);
+
+    std::vector<MethodSummary> summaries;
+    int method_id = -1;
+    for (auto & method_entry : conf.methods) {
+      method_id++;
+      const std::string & method_name = method_entry.first;
+      const ParameterSpace & space = method_entry.second;
+      std::vector<ParameterValues> values;
+      if (conf.search == "grid") {
+        values = space.getGrid();
+      }
+      else {
+        RandomStream candidates_stream = stream.withPurpose(RandomPurpose::Tuning);
+        values = space.getRandomCandidates(conf.nb_random_candidates,
+                                           candidates_stream.withSubstream(method_id));
+      }
+      std::vector<TuningCandidate> candidates(values.size());
+      for (size_t candidate = 0; candidate < values.size(); candidate++) {
+        candidates[candidate].values = values[candidate];
+        candidates[candidate].trainer = space.buildTrainer(values[candidate], conf.nb_threads);
+      }
+      std::cout << "Tuning '" << method_name << "' on '" << function_name << "' ("
+                << candidates.size() << " candidates)" << std::endl;
+      TimeStamp tuning_start = TimeStamp::now();
+      int best = runSuccessiveHalving(candidates, folds, limits, conf.eta, conf.nb_workers);
+      double tuning_time = diffSec(tuning_start, TimeStamp::now());
+      // Detailed results and total cost of the evaluations
+      MethodSummary summary;
+      summary.method_name = method_name;
+      summary.best = candidates[best];
+      summary.nb_candidates = candidates.size();
+      summary.nb_evaluations = 0;
+      summary.evaluation_time = 0;
+      summary.tuning_time = tuning_time;
+      for (const TuningCandidate & candidate : candidates) {
+        candidates_out << function_name << ","
+                       << method_name << ","
+                       << ParameterSpace::toString(candidate.values) << ","
+                       << candidate.scores.size() << ","
+                       << candidate.pruned_rung << ","
+                       << candidate.getMeanSMSE() << ","
+                       << candidate.getMeanLearningTime() << ","
+                       << candidate.getMeanPredictionTime() << std::endl;
+        for (const FoldScore & score : candidate.scores) {
+          summary.nb_evaluations++;
+          summary.evaluation_time += score.learning_time + score.prediction_time;
+        }
+      }
+      std::cout << "\tbest: " << ParameterSpace::toString(summary.best.values)
+                << " (smse: " << summary.best.getMeanSMSE() << ")" << std::endl;
+      summaries.push_back(summary);
+    }
+    // Best configuration of each method, flagging the best for the function
+    size_t best_summary = 0;
+    for (size_t i = 1; i < summaries.size(); i++) {
+      if (summaries[i].best.getMeanSMSE() < summaries[best_summary].best.getMeanSMSE()) {
+        best_summary = i;
+      }
+    }
+    for (size_t i = 0; i < summaries.size(); i++) {
+      const MethodSummary & summary = summaries[i];
+      best_out << function_name << ","
+               << summary.method_name << ","
+               << ParameterSpace::toString(summary.best.values) << ","
+               << summary.best.getMeanSMSE() << ","
+               << summary.best.getMeanLearningTime() << ","
+               << summary.best.getMeanPredictionTime() << ","
+               << summary.nb_candidates << ","
+               << summary.nb_evaluations << ","
+               << summary.evaluation_time << ","
+               << summary.tuning_time << ","
+               << (i == best_summary) << std::endl;
+    }
+  }
+
+  if (conf.trace_path != "") {
+    TraceRecorder::getInstance().writeJson(conf.trace_path);
+  }
+}